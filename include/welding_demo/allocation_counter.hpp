@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+namespace welding_demo
+{
+// Heap allocations of the whole process so far. They are counted only when the node is built with
+// the WELDING_DEMO_COUNT_ALLOCATIONS option, which replaces the global operator new in
+// welding_demo_node (src/counting_operator_new.cpp); otherwise the count stays 0.
+std::uint64_t heapAllocations();
+bool countingHeapAllocations();
+void countHeapAllocation();  // called by the replaced operator new
+}  // namespace welding_demo
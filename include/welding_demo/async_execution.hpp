@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <control_msgs/action/follow_joint_trajectory.hpp>
+#include <geometry_msgs/msg/pose.hpp>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit_msgs/msg/robot_trajectory.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp_action/rclcpp_action.hpp>
+
+namespace welding_demo
+{
+// How far an execution has come along its trajectory, from the controller feedback
+struct ExecutionProgress
+{
+  std::size_t point = 0;  // trajectory point the controller has reached
+  std::size_t waypoint = 0;  // seam waypoint passed last
+  double arc_length = 0.0;  // tool path length covered
+  double total_length = 0.0;
+};
+
+// A trajectory on its way through the controller. It is shared by the caller and the action
+// callbacks, which run on the node's executor; all members are thread safe.
+class Execution
+{
+public:
+  enum class State
+  {
+    PENDING,  // sent, not yet accepted
+    ACTIVE,
+    SUCCEEDED,
+    ABORTED,
+    CANCELED,
+    REJECTED  // by the controller, or no controller was available
+  };
+
+  State state() const;
+  bool done() const;
+  ExecutionProgress progress() const;
+  // Blocks until the execution is done or the timeout expires, returns done()
+  bool wait(std::chrono::milliseconds timeout = std::chrono::milliseconds::max()) const;
+  // Preempts the motion, the controller stops the arm and the execution ends as CANCELED
+  void cancel();
+
+  // Joint positions the trajectory ends in, the start state for whatever is planned next
+  const std::vector<std::string>& jointNames() const
+  {
+    return joint_names_;
+  }
+  const std::vector<double>& finalPositions() const
+  {
+    return final_positions_;
+  }
+
+private:
+  friend class AsyncExecutor;
+  using Action = control_msgs::action::FollowJointTrajectory;
+  using GoalHandle = rclcpp_action::ClientGoalHandle<Action>;
+
+  void finish(State state);
+
+  mutable std::mutex mutex_;
+  mutable std::condition_variable finished_;
+  State state_ = State::PENDING;
+  ExecutionProgress progress_;
+  bool cancel_requested_ = false;
+  GoalHandle::SharedPtr goal_handle_;
+  std::weak_ptr<rclcpp_action::Client<Action>> client_;
+
+  // Set before the goal is sent, read-only afterwards
+  std::vector<std::string> joint_names_;
+  std::vector<double> final_positions_;
+  std::vector<double> point_times_;  // time from start of every trajectory point
+  std::vector<double> point_lengths_;
+  std::vector<double> waypoint_lengths_;
+};
+
+using ExecutionPtr = std::shared_ptr<Execution>;
+
+// Executes joint trajectories through the FollowJointTrajectory action of the arm controller
+// without blocking. execute() sends the goal and returns right away; the returned Execution is
+// updated from the controller feedback and can be waited for or preempted. The node must be
+// spun by an executor for the action callbacks to run.
+class AsyncExecutor
+{
+public:
+  AsyncExecutor(const rclcpp::Node::SharedPtr& node, const std::string& action_name);
+
+  // ``point_lengths`` (tool path length at every trajectory point) and ``waypoint_lengths``
+  // (length along the seam at every waypoint), both cumulative, turn the controller feedback
+  // into arc length and waypoint progress. The tool path may be longer than the seam (weaving),
+  // the waypoint is taken at the same fraction of both. Either can be left empty.
+  ExecutionPtr execute(const moveit_msgs::msg::RobotTrajectory& trajectory,
+                       std::vector<double> point_lengths = {},
+                       std::vector<double> waypoint_lengths = {});
+
+private:
+  using Action = control_msgs::action::FollowJointTrajectory;
+
+  rclcpp::Logger logger_;
+  std::shared_ptr<rclcpp_action::Client<Action>> client_;
+};
+
+// Cumulative tool path length at every point of ``trajectory``, by forward kinematics of ``tip``
+// in the scratch ``state``
+std::vector<double> toolPathLengths(const moveit_msgs::msg::RobotTrajectory& trajectory,
+                                    moveit::core::RobotState& state,
+                                    const moveit::core::LinkModel* tip);
+// Cumulative length of the polyline through ``waypoints``
+std::vector<double> waypointPathLengths(const std::vector<geometry_msgs::msg::Pose>& waypoints);
+}  // namespace welding_demo
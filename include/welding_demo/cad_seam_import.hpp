@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <welding_demo/seam_buffer.hpp>
+#include <welding_demo/triangle_mesh.hpp>
+
+namespace welding_demo
+{
+// A seam drawn on the part: a polyline in the mesh frame, on or close to the surface
+struct SeamCurve
+{
+  std::string name;
+  std::vector<Eigen::Vector3f> points;
+};
+
+// Seam files list one curve after the other: a "seam <name>" line followed by one "x y z" line
+// per point. Empty lines and lines starting with '#' are ignored. Points are scaled like the mesh.
+bool loadSeamCurves(const std::string& path, std::vector<SeamCurve>& curves, float scale = 1.0f);
+
+struct CadSeamOptions
+{
+  float sample_step = 0.01f;  // distance between waypoints along the curve
+  float normal_radius = 0.003f;  // faces this close to a waypoint contribute to its normal
+  float max_projection_distance = 0.01f;  // samples farther from the surface are dropped
+  std::size_t threads = 0;  // 0 uses the hardware concurrency
+};
+
+// Resamples every curve at ``sample_step`` along its length and projects the samples onto the
+// mesh. The normal at a sample is the mean of the distinct face normals around it, which is the
+// bisector of both faces on a fillet or edge seam. The samples of all curves are processed in
+// parallel. Seams are appended to ``seams`` as pose batches in the planning frame (``part_pose``
+// places the mesh frame), oriented like the generated circle seam.
+void sampleCadSeams(const MeshBvh& bvh, const std::vector<SeamCurve>& curves,
+                    const Eigen::Isometry3d& part_pose, const CadSeamOptions& options,
+                    SeamBuffer& seams);
+}  // namespace welding_demo
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace welding_demo
+{
+// How a closed seam is sampled: a fixed number of segments around the loop or a maximum
+// spacing, and how far the weld runs past its start point to close the seam.
+struct ClosedSeamSampling
+{
+  std::size_t count = 0;  // segments around the loop, 0 derives it from ``max_spacing``
+  double max_spacing = 0.01;  // arc length
+  double overlap = 0.0;  // arc length welded past the start point, negative leaves a gap
+};
+
+// Arc length positions of the samples of a closed curve of length ``perimeter``. Positions are
+// computed from their index in double precision, never accumulated: the spacing is exactly
+// ``perimeter / count`` and the start point comes back exactly at ``perimeter``. An overlap is
+// split into even steps of at most that spacing and ends exactly at ``perimeter + overlap``; a
+// negative overlap shortens the seam, which is then spaced evenly up to its end.
+std::vector<double> closedSeamPositions(double perimeter, const ClosedSeamSampling& sampling);
+}  // namespace welding_demo
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+namespace welding_demo
+{
+// Reduction of raw scans before normal estimation and seam extraction.
+//
+// Cropping to the fixture region and voxel-grid downsampling are done in one pass over the
+// points. The scan is split into chunks that are processed in parallel, each thread accumulating
+// the points of every occupied voxel in its own open-addressing hash grid; the grids are merged
+// at the end, which only touches occupied voxels. Every voxel is replaced by the centroid of its
+// points.
+struct PreprocessingOptions
+{
+  Eigen::AlignedBox3f roi;  // empty box: no cropping
+  float voxel_size = 0.002f;  // <= 0: no downsampling
+  std::size_t threads = 0;  // 0 uses the hardware concurrency
+};
+
+// Crop and downsample ``points`` (one column per point) into ``out``, which is resized to the
+// reduced cloud
+void cropAndDownsample(const Eigen::Ref<const Eigen::Matrix3Xf>& points,
+                       const PreprocessingOptions& options, Eigen::Matrix3Xf& out);
+
+// The finite x, y, z points of a PointCloud2 message, one column per point. Clouds without x, y
+// and z fields give no points.
+void cloudPoints(const sensor_msgs::msg::PointCloud2& cloud, Eigen::Matrix3Xf& out);
+}  // namespace welding_demo
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <Eigen/Core>
+
+namespace welding_demo
+{
+// A point cloud slot of the ring buffer, read in place
+struct CloudView
+{
+  const float* data = nullptr;  // x, y, z of every point
+  uint32_t point_count = 0;
+  uint64_t stamp_ns = 0;  // system clock time of the scan
+  uint64_t sequence = 0;  // number of the cloud, starting at 1
+
+  Eigen::Map<const Eigen::Matrix3Xf> points() const
+  {
+    return Eigen::Map<const Eigen::Matrix3Xf>(data, 3, point_count);
+  }
+};
+
+// Point cloud transport through a POSIX shared memory ring buffer.
+//
+// A single producer (a sensor driver, or cloud_replay) writes every scan straight into the next
+// slot of the ring, consumers in other processes read the latest slot in place: no serialization
+// and no copy on either side. Slots are guarded by a sequence lock; a consumer checks
+// ``stillValid()`` after processing a view to detect that the producer has lapped it and
+// overwritten the slot meanwhile. A restarted producer creates a new buffer under the same name;
+// consumers check ``replaced()`` and reopen it.
+class CloudRingBuffer
+{
+public:
+  // Open an existing buffer as a consumer. A buffer that does not exist (yet) is only logged at
+  // debug level, consumers retry until the producer is up.
+  explicit CloudRingBuffer(const std::string& name);
+  // Create (or replace) a buffer as the producer
+  CloudRingBuffer(const std::string& name, uint32_t slots, uint32_t max_points);
+  ~CloudRingBuffer();
+
+  CloudRingBuffer(const CloudRingBuffer&) = delete;
+  CloudRingBuffer& operator=(const CloudRingBuffer&) = delete;
+
+  bool isOpen() const
+  {
+    return header_ != nullptr;
+  }
+  uint32_t maxPoints() const;
+
+  // Producer: storage for ``point_count`` points in the next slot (null if the cloud is too
+  // large), then publish it with the time of the scan
+  float* beginWrite(uint32_t point_count);
+  void commit(uint64_t stamp_ns);
+
+  // Consumer: the latest cloud if it is newer than ``after_sequence``
+  bool latest(CloudView& view, uint64_t after_sequence = 0) const;
+  bool stillValid(const CloudView& view) const;
+  // Consumer: true once the buffer under this name is not the one mapped, because the producer
+  // has restarted (new sequence numbers from 1) or is gone
+  bool replaced() const;
+
+  // System clock in nanoseconds, the time base of the cloud stamps
+  static uint64_t nowNs();
+
+private:
+  struct Header;
+  struct Slot;
+
+  Slot* slot(uint64_t index) const;
+
+  std::string name_;
+  bool owner_ = false;
+  std::size_t size_ = 0;
+  Header* header_ = nullptr;
+  uint64_t pending_ = 0;  // index of the cloud being written
+  uint64_t device_ = 0;  // identity of the mapped shared memory object
+  uint64_t inode_ = 0;
+};
+}  // namespace welding_demo
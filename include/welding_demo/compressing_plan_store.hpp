@@ -0,0 +1,37 @@
+#pragma once
+
+#include <welding_demo/plan_store.hpp>
+
+namespace welding_demo
+{
+// PlanStore decorator that keeps trajectories compressed (see compressTrajectory()). Plans are
+// reduced to their Hermite knots before they reach the underlying store and are resampled at a
+// fixed period when they are loaded again, so callers always see dense, executable trajectories.
+class CompressingPlanStore : public PlanStore
+{
+public:
+  CompressingPlanStore(PlanStorePtr store, double tolerance, double period);
+
+  bool storeTrajectory(const std::string& kind, uint64_t key,
+                       const moveit_msgs::msg::RobotTrajectory& trajectory) override;
+  bool loadTrajectory(const std::string& kind, uint64_t key,
+                      moveit_msgs::msg::RobotTrajectory& trajectory) override;
+  std::size_t
+  loadTrajectories(const std::string& kind,
+                   std::vector<moveit_msgs::msg::RobotTrajectory>& trajectories) override;
+
+  bool storeSeed(uint64_t key, const std::vector<double>& positions) override
+  {
+    return store_->storeSeed(key, positions);
+  }
+  bool loadSeed(uint64_t key, std::vector<double>& positions) override
+  {
+    return store_->loadSeed(key, positions);
+  }
+
+private:
+  PlanStorePtr store_;
+  double tolerance_;
+  double period_;
+};
+}  // namespace welding_demo
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include <welding_demo/plan_store.hpp>
+
+namespace welding_demo
+{
+// Embedded PlanStore for cells without a database process.
+//
+// Records are appended to a single log file and never rewritten; a newer record with the same kind
+// and key shadows the older one. On startup the log is memory-mapped and scanned once to build an
+// in-memory hash index of record offsets, so a lookup is a hash probe plus deserializing the
+// message straight from the mapping. The log starts with a file header (magic and format version);
+// files without it, of another version, or with a corrupted record are not opened. Every record
+// carries a CRC-32 of its payload, verified by the startup scan. A torn record at the end of the
+// log (e.g. after a power loss) is cut off on open. The log is locked (flock) while it is open, a
+// second node opening the same file fails instead of interleaving its records.
+class FilePlanStore : public PlanStore
+{
+public:
+  explicit FilePlanStore(const std::string& path);
+  ~FilePlanStore() override;
+
+  FilePlanStore(const FilePlanStore&) = delete;
+  FilePlanStore& operator=(const FilePlanStore&) = delete;
+
+  bool isOpen() const
+  {
+    return fd_ >= 0;
+  }
+  std::size_t size() const
+  {
+    return index_.size();
+  }
+
+  bool storeTrajectory(const std::string& kind, uint64_t key,
+                       const moveit_msgs::msg::RobotTrajectory& trajectory) override;
+  bool loadTrajectory(const std::string& kind, uint64_t key,
+                      moveit_msgs::msg::RobotTrajectory& trajectory) override;
+  std::size_t
+  loadTrajectories(const std::string& kind,
+                   std::vector<moveit_msgs::msg::RobotTrajectory>& trajectories) override;
+
+  bool storeSeed(uint64_t key, const std::vector<double>& positions) override;
+  bool loadSeed(uint64_t key, std::vector<double>& positions) override;
+
+private:
+  struct IndexKey
+  {
+    uint64_t kind;
+    uint64_t key;
+    bool operator==(const IndexKey& other) const
+    {
+      return kind == other.kind && key == other.key;
+    }
+  };
+  struct IndexKeyHash
+  {
+    std::size_t operator()(const IndexKey& k) const
+    {
+      return static_cast<std::size_t>(k.key ^ (k.kind * 0x9e3779b97f4a7c15ull));
+    }
+  };
+  struct Entry
+  {
+    std::size_t offset;  // payload offset in the log
+    std::size_t size;    // payload size
+  };
+
+  bool append(uint64_t kind, uint64_t key, const void* payload, std::size_t size);
+  const Entry* find(uint64_t kind, uint64_t key);
+  // Map the log up to its current end, picking up records appended since the last mapping
+  bool remap();
+  // Index the records from ``from`` on. Returns false if a record other than the last is damaged.
+  bool scan(std::size_t from);
+  void closeFile();
+
+  std::string path_;
+  int fd_ = -1;
+  const unsigned char* mapping_ = nullptr;
+  std::size_t mapped_size_ = 0;
+  std::size_t file_size_ = 0;
+  std::unordered_map<IndexKey, Entry, IndexKeyHash> index_;
+};
+}  // namespace welding_demo
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <geometry_msgs/msg/pose.hpp>
+#include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit_msgs/msg/robot_trajectory.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+namespace welding_demo
+{
+// Cartesian path planning inside the welding node.
+//
+// MoveGroupInterface::computeCartesianPath() sends the waypoints to the move_group node and gets
+// the trajectory back over a service, serializing both. This planner runs the same steps in
+// process: Cartesian interpolation with IK on the shared robot model, collision checking against
+// a local planning scene kept in sync with move_group's monitored scene, and time-optimal time
+// parameterization.
+class LocalCartesianPlanner
+{
+public:
+  LocalCartesianPlanner(const rclcpp::Node::SharedPtr& node,
+                        const robot_model_loader::RobotModelLoaderPtr& robot_model_loader,
+                        const std::string& group, const std::string& tip_link);
+
+  // Plan through ``waypoints`` (in the model frame) starting from ``start`` (positions of the
+  // group's active joints, the other joints are taken from the current state). Returns the
+  // fraction of the path that was achieved, like MoveGroupInterface::computeCartesianPath().
+  double plan(const std::vector<double>& start,
+              const std::vector<geometry_msgs::msg::Pose>& waypoints, double eef_step,
+              double jump_threshold, moveit_msgs::msg::RobotTrajectory& trajectory,
+              bool avoid_collisions = true);
+
+  bool ready() const
+  {
+    return group_ && tip_;
+  }
+
+private:
+  planning_scene_monitor::PlanningSceneMonitorPtr monitor_;
+  const moveit::core::JointModelGroup* group_ = nullptr;
+  const moveit::core::LinkModel* tip_ = nullptr;
+};
+}  // namespace welding_demo
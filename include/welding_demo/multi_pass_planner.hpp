@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Geometry>
+#include <geometry_msgs/msg/pose.hpp>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit_msgs/msg/robot_trajectory.hpp>
+
+namespace welding_demo
+{
+// Fill and cap passes of a multi-pass weld, placed relative to the root pass.
+//
+// The offset is given in the seam frame: ``lateral`` across the seam (seam normal x travel
+// direction) and ``lift`` along the seam normal (seamNormal()), away from the workpiece.
+struct PassOffset
+{
+  double lateral = 0.0;
+  double lift = 0.0;
+};
+
+// Offset a sequence of tool poses. The seam frame of a pose whose travel direction is parallel to
+// the seam normal (approach and retract moves) is taken from the nearest seam pose, so the whole
+// path including approach and retract is shifted consistently.
+std::vector<Eigen::Isometry3d> offsetPath(const std::vector<Eigen::Isometry3d>& path,
+                                          const PassOffset& offset);
+std::vector<geometry_msgs::msg::Pose> offsetWaypoints(
+    const std::vector<geometry_msgs::msg::Pose>& waypoints, const PassOffset& offset);
+
+// Derive a pass from the planned root pass. Every root trajectory point is offset in Cartesian
+// space and re-solved with IK, seeded with the root pass joint solution at that point; the root
+// pass timing is kept. Seeded IK for an offset of a few millimeters converges in very few
+// iterations, so this costs a fraction of a Cartesian plan. Fails (returns false) when a point
+// has no IK solution or a joint would move more than ``max_joint_step`` beyond the root pass
+// motion between two points, in which case the caller falls back to Cartesian planning.
+bool derivePass(const moveit_msgs::msg::RobotTrajectory& root, moveit::core::RobotState& state,
+                const moveit::core::JointModelGroup* group, const moveit::core::LinkModel* tip,
+                const PassOffset& offset, moveit_msgs::msg::RobotTrajectory& pass,
+                double ik_timeout = 0.005, double max_joint_step = 0.05);
+}  // namespace welding_demo
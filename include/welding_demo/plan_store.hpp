@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <geometry_msgs/msg/pose.hpp>
+#include <moveit_msgs/msg/robot_trajectory.hpp>
+
+namespace welding_demo
+{
+// 64 bit FNV-1a hash of planning inputs. Doubles are rounded to a multiple of the quantum before
+// hashing, so repeated requests whose inputs round to the same multiples (e.g. sensor noise well
+// below the quantum) map to the same key. Inputs close to a rounding boundary can still round
+// apart and miss the stored plan; a miss only costs a new plan.
+class PlanKey
+{
+public:
+  PlanKey() = default;
+  // Continue hashing on top of an existing key
+  explicit PlanKey(uint64_t seed) : hash_(seed)
+  {
+  }
+
+  PlanKey& add(const std::string& value);
+  PlanKey& add(double value, double quantum);
+  PlanKey& add(const std::vector<double>& values, double quantum);
+  PlanKey& add(const std::vector<geometry_msgs::msg::Pose>& poses, double position_quantum = 1e-4,
+               double orientation_quantum = 1e-4);
+
+  uint64_t value() const
+  {
+    return hash_;
+  }
+  std::string str() const;
+
+private:
+  void mix(const void* data, std::size_t size);
+
+  uint64_t hash_ = 14695981039346656037ull;
+};
+
+// Persistent storage of planning results shared across restarts and cells: Cartesian seam
+// trajectories, joint-space transit plans and IK seeds. Trajectories are grouped by kind ("seam",
+// "transit") so that all plans of a kind can be loaded at once for warm starts.
+class PlanStore
+{
+public:
+  virtual ~PlanStore() = default;
+
+  virtual bool storeTrajectory(const std::string& kind, uint64_t key,
+                               const moveit_msgs::msg::RobotTrajectory& trajectory) = 0;
+  virtual bool loadTrajectory(const std::string& kind, uint64_t key,
+                              moveit_msgs::msg::RobotTrajectory& trajectory) = 0;
+  virtual std::size_t
+  loadTrajectories(const std::string& kind,
+                   std::vector<moveit_msgs::msg::RobotTrajectory>& trajectories) = 0;
+
+  virtual bool storeSeed(uint64_t key, const std::vector<double>& positions) = 0;
+  virtual bool loadSeed(uint64_t key, std::vector<double>& positions) = 0;
+};
+
+using PlanStorePtr = std::shared_ptr<PlanStore>;
+}  // namespace welding_demo
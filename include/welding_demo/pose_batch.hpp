@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <geometry_msgs/msg/pose.hpp>
+
+namespace welding_demo
+{
+// Structure-of-arrays batches: one contiguous row per component, one column per element. The
+// kernels below are whole-row array expressions, which Eigen vectorizes across elements.
+using Vector3Batch = Eigen::Matrix<double, 3, Eigen::Dynamic, Eigen::RowMajor>;  // x, y, z
+using QuaternionBatch = Eigen::Matrix<double, 4, Eigen::Dynamic, Eigen::RowMajor>;  // w, x, y, z
+
+// Poses as batches, converted to messages only where they leave for ROS
+struct PoseBatch
+{
+  Vector3Batch positions;
+  QuaternionBatch orientations;
+
+  Eigen::Index size() const
+  {
+    return positions.cols();
+  }
+  void resize(Eigen::Index n)
+  {
+    positions.resize(3, n);
+    orientations.resize(4, n);
+  }
+
+  void toMsgs(std::vector<geometry_msgs::msg::Pose>& poses) const;
+  void fromMsgs(const std::vector<geometry_msgs::msg::Pose>& poses);
+};
+
+// Hamilton products ``a * b``
+void compose(const QuaternionBatch& a, const QuaternionBatch& b, QuaternionBatch& out);
+// Shortest rotations taking ``from`` onto ``to`` (like Eigen::Quaterniond::FromTwoVectors);
+// opposite vectors turn half way round an axis perpendicular to ``from``
+void fromTwoVectors(const Vector3Batch& from, const Vector3Batch& to, QuaternionBatch& out);
+// Seam orientations for the surface ``normals``: the rotations taking every normal onto the tool
+// x axis (see seamNormal()). All seam sources build their orientations with it.
+void seamOrientations(const Vector3Batch& normals, QuaternionBatch& out);
+}  // namespace welding_demo
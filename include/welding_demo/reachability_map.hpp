@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Eigen/Geometry>
+
+namespace welding_demo
+{
+// Voxelized reachability map of the tool link, expressed in the robot base frame.
+//
+// Every voxel stores a bitmask of the tool approach directions (z-axis of the tool link) that were
+// reached by at least one sampled joint configuration, and the best manipulability index seen for
+// the voxel. The map is built offline by ``reachability_map_builder`` and loaded by the node
+// through ``mmap``, so queries are a handful of arithmetic operations and a memory read.
+class ReachabilityMap
+{
+public:
+  struct Cell
+  {
+    uint32_t direction_mask;
+    float manipulability;
+  };
+
+  // Number of direction bins: 3 dominant axes x 2 signs x 4 sub-quadrants
+  static constexpr int DIRECTION_BINS = 24;
+
+  ReachabilityMap() = default;
+  ~ReachabilityMap();
+
+  ReachabilityMap(const ReachabilityMap&) = delete;
+  ReachabilityMap& operator=(const ReachabilityMap&) = delete;
+  ReachabilityMap(ReachabilityMap&& other) noexcept;
+  ReachabilityMap& operator=(ReachabilityMap&& other) noexcept;
+
+  // Allocate an empty, writable map covering the given bounds
+  void allocate(const Eigen::AlignedBox3d& bounds, double resolution);
+
+  // Record a sampled tool pose and its manipulability index
+  void addSample(const Eigen::Isometry3d& tool_pose, double manipulability);
+
+  // Merge the samples of another map with identical geometry into this one
+  bool merge(const ReachabilityMap& other);
+
+  bool save(const std::string& path) const;
+
+  // Memory-map a map file written by save(). The map becomes read-only.
+  bool load(const std::string& path);
+
+  bool empty() const
+  {
+    return cells_ == nullptr;
+  }
+
+  // Cell containing the given point, or nullptr when it lies outside of the map
+  const Cell* cell(const Eigen::Vector3d& point) const;
+
+  // True when the pose position and tool approach direction were reached with at least the given
+  // manipulability
+  bool isReachable(const Eigen::Isometry3d& tool_pose, double min_manipulability = 0.0) const;
+
+  // Check if every pose of a seam (given in the workpiece frame) can be welded when the workpiece
+  // is placed at ``placement`` in the robot base frame. Returns the index of the first failing pose
+  // through ``failed_index`` if provided.
+  bool canWeld(const std::vector<Eigen::Isometry3d>& seam, const Eigen::Isometry3d& placement,
+               double min_manipulability = 0.0, std::size_t* failed_index = nullptr) const;
+
+  // Fraction of voxels reached in any direction, used for reporting
+  double coverage() const;
+
+  static int directionBin(const Eigen::Vector3d& direction);
+
+private:
+  bool index(const Eigen::Vector3d& point, std::size_t& idx) const;
+  void unmap();
+
+  Eigen::Vector3d origin_ = Eigen::Vector3d::Zero();
+  double resolution_ = 0.0;
+  uint32_t size_[3] = { 0, 0, 0 };
+
+  std::vector<Cell> storage_;  // used while building
+  Cell* cells_ = nullptr;      // points into storage_ or into the mapped file
+  void* mapping_ = nullptr;
+  std::size_t mapping_size_ = 0;
+};
+}  // namespace welding_demo
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace welding_demo
+{
+struct RegistrationOptions
+{
+  std::size_t max_iterations = 30;
+  float max_distance = 0.02f;  // scan points farther from the model are not matched
+  std::size_t max_points = 20000;  // scan points used per iteration, evenly strided
+  bool coarse = true;  // also try principal axis alignments, not only the initial guess
+  double translation_tolerance = 1e-5;  // convergence: update smaller than both tolerances
+  double rotation_tolerance = 1e-5;
+  std::size_t threads = 0;  // 0 uses the hardware concurrency
+};
+
+struct RegistrationResult
+{
+  Eigen::Isometry3d part_pose = Eigen::Isometry3d::Identity();  // model frame in the scan frame
+  double rmse = 0.0;  // of the matched points
+  double fitness = 0.0;  // fraction of scan points matched
+  std::size_t iterations = 0;
+  bool converged = false;
+  double elapsed_ms = 0.0;
+};
+
+// Estimates the placement of a part from a scan by aligning it to a model cloud of the part.
+//
+// The model is indexed once in a k-d tree. A coarse stage picks the best of the initial guess and
+// the alignments of the principal axes of scan and model; point-to-point ICP then refines it. The
+// nearest neighbour queries of every ICP iteration run in parallel, each thread accumulating its
+// share of the cross-covariance directly so matches are never stored.
+class ScanRegistration
+{
+public:
+  explicit ScanRegistration(Eigen::Matrix3Xf model);
+
+  RegistrationResult align(const Eigen::Ref<const Eigen::Matrix3Xf>& scan,
+                           const Eigen::Isometry3d& initial_pose,
+                           const RegistrationOptions& options) const;
+
+  std::size_t modelSize() const
+  {
+    return static_cast<std::size_t>(model_.cols());
+  }
+
+private:
+  void build(Eigen::Index begin, Eigen::Index end);
+  // Nearest model point to ``query`` closer than sqrt(``best_distance_sq``), -1 if there is none
+  Eigen::Index nearest(const Eigen::Vector3f& query, float& best_distance_sq) const;
+
+  // Points in k-d tree order: the median of every range is its split point
+  Eigen::Matrix3Xf model_;
+  std::vector<uint8_t> split_axis_;
+  Eigen::Vector3d model_centroid_;
+  Eigen::Matrix3d model_axes_;
+};
+}  // namespace welding_demo
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Eigen/Geometry>
+#include <geometry_msgs/msg/pose.hpp>
+
+namespace welding_demo
+{
+// Surface normal at a seam pose, pointing out of the workpiece. Seam orientations rotate the
+// surface normal onto the tool x axis (see the circle seam), so the normal is the tool x axis
+// rotated back into the planning frame.
+inline Eigen::Vector3d seamNormal(const Eigen::Quaterniond& orientation)
+{
+  return orientation.normalized().conjugate() * Eigen::Vector3d::UnitX();
+}
+
+inline Eigen::Vector3d seamNormal(const geometry_msgs::msg::Pose& pose)
+{
+  return seamNormal(Eigen::Quaterniond(pose.orientation.w, pose.orientation.x, pose.orientation.y,
+                                       pose.orientation.z));
+}
+
+// Of a tool pose, e.g. the forward kinematics of a planned seam trajectory
+inline Eigen::Vector3d seamNormal(const Eigen::Isometry3d& tool)
+{
+  return tool.linear().transpose() * Eigen::Vector3d::UnitX();
+}
+}  // namespace welding_demo
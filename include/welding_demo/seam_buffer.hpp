@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <Eigen/Geometry>
+#include <geometry_msgs/msg/pose.hpp>
+
+#include <welding_demo/pose_batch.hpp>
+namespace welding_demo
+{
+// The seams of one cycle, stored back to back in a single structure-of-arrays pose batch.
+//
+// clear() only forgets the contents: the batch, the seam table and the names keep their storage,
+// and grow geometrically when a cycle needs more. Once the largest cycle has been seen, filling
+// the buffer and reading seams out of it does not allocate.
+class SeamBuffer
+{
+public:
+  void clear()
+  {
+    seam_count_ = 0;
+    pose_count_ = 0;
+    offsets_.assign(1, 0);
+  }
+  // The seam sources append their pose batches as they are, without going through messages
+  void add(const std::string& name, const PoseBatch& poses);
+  void add(const std::string& name, const std::vector<geometry_msgs::msg::Pose>& waypoints);
+  // Moves all seams by ``transform`` in one batch, e.g. from the nominal to the measured part
+  // placement. Seam orientations rotate the surface normal onto the tool x axis (see
+  // seamOrientations()), so a rotated surface is undone first.
+  void transform(const Eigen::Isometry3d& transform);
+
+  std::size_t size() const
+  {
+    return seam_count_;
+  }
+  bool empty() const
+  {
+    return seam_count_ == 0;
+  }
+  const std::string& name(std::size_t seam) const
+  {
+    return names_[seam];
+  }
+  std::size_t waypointCount(std::size_t seam) const
+  {
+    return static_cast<std::size_t>(offsets_[seam + 1] - offsets_[seam]);
+  }
+
+  Eigen::Isometry3d pose(std::size_t seam, std::size_t waypoint) const
+  {
+    return columnPose(offsets_[seam] + static_cast<Eigen::Index>(waypoint));
+  }
+
+  // Adapters to the containers the planners take, optionally in reverse order. The output is
+  // overwritten in place: a vector reused across seams and cycles keeps its capacity, so it only
+  // allocates when a seam is longer than any before.
+  void waypoints(std::size_t seam, bool reversed,
+                 std::vector<geometry_msgs::msg::Pose>& poses) const;
+  void transforms(std::size_t seam, bool reversed,
+                  std::vector<Eigen::Isometry3d>& transforms) const;
+
+private:
+  // Makes room for ``count`` more poses, keeping the stored ones
+  void reserveMore(Eigen::Index count);
+  void finishSeam(const std::string& name);
+  Eigen::Isometry3d columnPose(Eigen::Index column) const;
+
+  PoseBatch batch_;  // columns beyond ``pose_count_`` are spare capacity
+  Eigen::Index pose_count_ = 0;
+  std::size_t seam_count_ = 0;
+  std::vector<Eigen::Index> offsets_ = { 0 };  // first pose of every seam, and the end
+  std::vector<std::string> names_;  // entries beyond ``seam_count_`` are kept for reuse
+};
+}  // namespace welding_demo
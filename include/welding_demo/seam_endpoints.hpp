@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <moveit/robot_state/robot_state.h>
+
+#include <welding_demo/seam_buffer.hpp>
+
+namespace welding_demo
+{
+// Solve IK for the first and last waypoint of every seam, seeded from ``home``. The result follows
+// the SeamSequencer endpoint layout: entry ``2 * i`` is the start of seam ``i``, ``2 * i + 1`` its
+// end and the last entry is the home configuration. Endpoints without an IK solution keep the home
+// configuration; their count is returned.
+std::size_t solveSeamEndpoints(const SeamBuffer& seams, const moveit::core::RobotState& home,
+                               const moveit::core::JointModelGroup* group,
+                               std::vector<Eigen::VectorXd>& configurations,
+                               double ik_timeout = 0.05);
+
+// Velocity limits of the active joints of a group, used for transit time estimates
+Eigen::VectorXd maxJointVelocities(const moveit::core::JointModelGroup* group,
+                                   double default_velocity = 1.0);
+}  // namespace welding_demo
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <welding_demo/seam_buffer.hpp>
+
+namespace welding_demo
+{
+// A plane segmented from a scan, ``normal.dot(p) + offset == 0`` for points on it. The normal
+// faces the sensor.
+struct ScanPlane
+{
+  Eigen::Vector3f normal;
+  float offset;
+  std::vector<int> inliers;  // columns of the scan
+};
+
+struct SeamExtractionOptions
+{
+  float distance_threshold = 0.002f;  // inlier distance of plane points
+  std::size_t iterations = 400;  // RANSAC hypotheses per plane
+  std::size_t sample_size = 20000;  // points the hypotheses are scored on
+  std::size_t min_plane_points = 200;
+  std::size_t max_planes = 8;
+  float min_angle = 0.35f;  // smallest angle between two planes that forms a seam, rad
+  float max_gap = 0.006f;  // widest gap between coplanar plates that forms a butt seam, 0: none
+  // Cell size of the plane rasters the gaps are searched in; gaps narrower than two cells close
+  float gap_resolution = 0.002f;
+  float seam_distance = 0.004f;  // plane points this close to the intersection line support it
+  float sample_step = 0.01f;  // distance between seam waypoints
+  float min_length = 0.03f;  // shorter seam segments are dropped
+  Eigen::Vector3f viewpoint = Eigen::Vector3f::Zero();  // sensor origin, in the scan frame
+  std::size_t threads = 0;  // 0 uses the hardware concurrency
+};
+
+// Greedy multi-plane RANSAC: the dominant plane is found, its inliers removed, and so on until
+// ``max_planes`` planes are found or no plane with ``min_plane_points`` is left. The hypotheses of
+// every round are generated and scored in parallel on a random subset of the remaining points;
+// the best one is refined by a least-squares fit to all of its inliers.
+std::vector<ScanPlane> segmentPlanes(const Eigen::Ref<const Eigen::Matrix3Xf>& points,
+                                     const SeamExtractionOptions& options);
+
+// Seams along the intersection lines of pairs of planes (fillet seams, beveled butt seams) and
+// along the gaps inside single planes (butt seams between coplanar plates, which RANSAC merges into
+// one plane). An intersection seam only covers the parts of the line where both planes have points
+// close by; interruptions split it into several seams. A gap seam runs between two separate
+// regions of a plane's inliers that are at most ``max_gap`` apart, along the line fitted to the
+// gap midpoints. Seams are appended to ``seams`` as pose batches, with the seam normal (the
+// bisector of both plane normals, or the plane normal for a gap) rotated onto the tool x axis,
+// like the generated circle seam.
+void extractSeams(const Eigen::Ref<const Eigen::Matrix3Xf>& points,
+                  const std::vector<ScanPlane>& planes, const SeamExtractionOptions& options,
+                  SeamBuffer& seams);
+}  // namespace welding_demo
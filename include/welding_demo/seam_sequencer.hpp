@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <Eigen/Core>
+
+namespace welding_demo
+{
+// Fast estimate of the time needed for a synchronized joint-space move between two
+// configurations: the slowest joint determines the duration.
+double estimateTransitTime(const Eigen::VectorXd& from, const Eigen::VectorXd& to,
+                           const Eigen::VectorXd& max_velocity);
+
+// Pairwise transit time estimates between joint configurations, see estimateTransitTime()
+Eigen::MatrixXd transitCostMatrix(const std::vector<Eigen::VectorXd>& configurations,
+                                  const Eigen::VectorXd& max_velocity);
+
+// One entry of a seam sequence: which seam to weld next and in which direction
+struct SequencedSeam
+{
+  std::size_t seam;
+  bool reversed;
+};
+
+// Orders a set of seams and picks their welding direction so that the total air-move time is
+// minimal. The problem is a TSP over seams where every seam can be entered from either end; it is
+// solved with randomized nearest-neighbour starts improved by 2-opt and Or-opt moves. The restarts
+// run in parallel and the best tour wins.
+//
+// Costs are given per seam endpoint. Endpoint ``2 * i`` is the start of seam ``i`` and endpoint
+// ``2 * i + 1`` is its end; the last row/column of the transit matrix is the home pose.
+class SeamSequencer
+{
+public:
+  struct Options
+  {
+    std::size_t restarts = 16;
+    std::size_t threads = 0;  // 0 uses the hardware concurrency
+    bool return_home = true;
+  };
+
+  // ``transit`` is a symmetric (2n + 1) x (2n + 1) matrix of move costs between endpoints
+  explicit SeamSequencer(Eigen::MatrixXd transit);
+
+  std::size_t seamCount() const
+  {
+    return seam_count_;
+  }
+
+  std::vector<SequencedSeam> solve(const Options& options, double* total_cost = nullptr) const;
+
+  // Air-move cost of a given sequence
+  double cost(const std::vector<SequencedSeam>& sequence, bool return_home) const;
+
+private:
+  std::size_t entry(const SequencedSeam& s) const
+  {
+    return 2 * s.seam + (s.reversed ? 1 : 0);
+  }
+  std::size_t exit(const SequencedSeam& s) const
+  {
+    return 2 * s.seam + (s.reversed ? 0 : 1);
+  }
+
+  std::vector<SequencedSeam> nearestNeighbour(std::size_t first, bool reversed) const;
+  bool twoOpt(std::vector<SequencedSeam>& tour, bool return_home) const;
+  bool orOpt(std::vector<SequencedSeam>& tour, bool return_home) const;
+
+  Eigen::MatrixXd transit_;
+  std::size_t seam_count_;
+  std::size_t home_;
+};
+}  // namespace welding_demo
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <geometry_msgs/msg/pose.hpp>
+
+#include <welding_demo/closed_seam_sampling.hpp>
+
+namespace welding_demo
+{
+// Continuous seam path through a set of waypoints, parameterized by arc length.
+//
+// Positions are interpolated by piecewise cubic Hermite segments over chord-length knots, with
+// tangents from the parabola through each point and its neighbours (C1). Orientations are
+// interpolated by SQUAD, which passes through every waypoint orientation with continuous angular
+// velocity. An arc-length table (Gauss-Legendre quadrature per segment) maps distances along the
+// seam to segment parameters, so the seam can be resampled at any density without keeping dense
+// arrays around: only the waypoints, their tangents and the table are stored.
+class SeamSpline
+{
+public:
+  SeamSpline() = default;
+  // A closed spline also interpolates from the last waypoint back to the first
+  explicit SeamSpline(const std::vector<geometry_msgs::msg::Pose>& waypoints, bool closed = false);
+
+  double length() const
+  {
+    return lengths_.empty() ? 0.0 : lengths_.back();
+  }
+  bool empty() const
+  {
+    return points_.size() < 2;
+  }
+
+  // Evaluation at arc length ``s``, clamped to [0, length()]
+  Eigen::Vector3d position(double s) const;
+  Eigen::Vector3d tangent(double s) const;  // unit, analytic derivative of the position
+  Eigen::Quaterniond orientation(double s) const;
+  Eigen::Vector3d normal(double s) const;  // surface normal, seamNormal() of the orientation
+  geometry_msgs::msg::Pose pose(double s) const;
+
+  // Poses at (at most) ``step`` apart, including both ends
+  std::vector<geometry_msgs::msg::Pose> sample(double step) const;
+  // Poses around a closed spline, with the start point and overlap of closedSeamPositions()
+  std::vector<geometry_msgs::msg::Pose> sample(const ClosedSeamSampling& sampling) const;
+
+private:
+  // Segment and its local parameter in [0, 1] at arc length ``s``
+  void locate(double s, std::size_t& segment, double& u) const;
+  Eigen::Vector3d derivative(std::size_t segment, double u) const;  // of the position by ``u``
+  double speed(std::size_t segment, double u) const;
+  double segmentLength(std::size_t segment, double u) const;  // from 0 to ``u``
+
+  std::vector<Eigen::Vector3d> points_;
+  std::vector<Eigen::Vector3d> tangents_;  // derivatives per unit of chord length
+  std::vector<Eigen::Quaterniond> orientations_;
+  std::vector<Eigen::Quaterniond> controls_;  // SQUAD inner control quaternions
+  std::vector<double> lengths_;  // cumulative arc length at the start of every segment, and end
+};
+}  // namespace welding_demo
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <rclcpp/logger.hpp>
+
+namespace welding_demo
+{
+// Wall-clock timing of the node startup, split into named phases. Starting a phase ends the
+// previous one.
+class StartupProfiler
+{
+public:
+  StartupProfiler();
+
+  void phase(const std::string& name);
+  void finish();
+
+  double totalMs() const;
+
+  // Log the time to ready, with a per-phase breakdown if ``detailed`` is set
+  void report(const rclcpp::Logger& logger, bool detailed) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point start_;
+  Clock::time_point phase_start_;
+  Clock::time_point end_;
+  std::string current_;
+  std::vector<std::pair<std::string, double>> phases_;
+};
+}  // namespace welding_demo
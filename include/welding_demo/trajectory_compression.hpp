@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <trajectory_msgs/msg/joint_trajectory.hpp>
+
+namespace welding_demo
+{
+// Piecewise cubic Hermite compression of joint trajectories.
+//
+// A dense trajectory (e.g. a Cartesian path sampled every 1 cm) is reduced to a subset of its
+// points, the knots. Between two knots the positions are reproduced by the cubic Hermite
+// polynomial defined by the knot positions and velocities, which is also the interpolation the
+// joint trajectory controller applies to position + velocity goals. Knots are chosen greedily so
+// that no dropped point deviates by more than the tolerance in any joint.
+
+// Cubic Hermite interpolation on [t0, t1] at time t, writes position and (optionally) velocity and
+// acceleration
+void hermite(double t0, const Eigen::Ref<const Eigen::VectorXd>& q0,
+             const Eigen::Ref<const Eigen::VectorXd>& v0, double t1,
+             const Eigen::Ref<const Eigen::VectorXd>& q1,
+             const Eigen::Ref<const Eigen::VectorXd>& v1, double t, Eigen::Ref<Eigen::VectorXd> q,
+             Eigen::VectorXd* v = nullptr, Eigen::VectorXd* a = nullptr);
+
+// Indices of the knots to keep. ``positions`` and ``velocities`` hold one row per sample. The
+// first and last sample are always kept.
+std::vector<std::size_t> selectKnots(const Eigen::VectorXd& times,
+                                     const Eigen::MatrixXd& positions,
+                                     const Eigen::MatrixXd& velocities, double tolerance);
+
+// Central difference velocity estimate, used when a trajectory carries no velocities
+Eigen::MatrixXd estimateVelocities(const Eigen::VectorXd& times, const Eigen::MatrixXd& positions);
+
+// Reduce ``in`` to its knots. The result keeps positions and velocities only.
+void compressTrajectory(const trajectory_msgs::msg::JointTrajectory& in,
+                        trajectory_msgs::msg::JointTrajectory& out, double tolerance);
+
+// Resample a compressed trajectory at a fixed period, restoring dense positions, velocities and
+// accelerations for execution. The last point is the end of ``in``; the times strictly increase.
+void decompressTrajectory(const trajectory_msgs::msg::JointTrajectory& in,
+                          trajectory_msgs::msg::JointTrajectory& out, double period);
+}  // namespace welding_demo
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <moveit_msgs/msg/robot_trajectory.hpp>
+
+namespace welding_demo
+{
+// Owner of a seam trajectory on its way from planning through validation and visualization to
+// execution. The handle is move-only, so handing it on between stages never copies points.
+// Read-only consumers share() the trajectory instead of copying it; writing to a trajectory that
+// is still shared copies it first (copy-on-write), which keeps the shared readers consistent.
+// Every point copied that way is counted in copiedPoints(), so stray copies show up in the logs.
+// A moved-from handle holds no trajectory until edit() is called on it.
+class TrajectoryHandle
+{
+public:
+  TrajectoryHandle();
+  explicit TrajectoryHandle(moveit_msgs::msg::RobotTrajectory&& trajectory);
+  TrajectoryHandle(const TrajectoryHandle&) = delete;
+  TrajectoryHandle& operator=(const TrajectoryHandle&) = delete;
+  TrajectoryHandle(TrajectoryHandle&&) = default;
+  TrajectoryHandle& operator=(TrajectoryHandle&&) = default;
+
+  const moveit_msgs::msg::RobotTrajectory& operator*() const
+  {
+    return *trajectory_;
+  }
+  const moveit_msgs::msg::RobotTrajectory* operator->() const
+  {
+    return trajectory_.get();
+  }
+  // For the stages that modify the trajectory in place
+  moveit_msgs::msg::RobotTrajectory& edit();
+  std::shared_ptr<const moveit_msgs::msg::RobotTrajectory> share() const
+  {
+    return trajectory_;
+  }
+  // Moves the trajectory out, leaving the handle empty
+  moveit_msgs::msg::RobotTrajectory release();
+
+  // Trajectory points deep-copied by all handles of the process, including the copies reported
+  // with countCopy()
+  static std::size_t copiedPoints();
+  // Reports a deep copy of a handle's trajectory made outside the handle, where a consumer takes
+  // the trajectory by value: serialized into the plan store or into a controller goal
+  static void countCopy(const moveit_msgs::msg::RobotTrajectory& trajectory);
+
+private:
+  // Gives the handle sole ownership, copying the trajectory if it is shared
+  void unshare();
+
+  std::shared_ptr<moveit_msgs::msg::RobotTrajectory> trajectory_;
+};
+}  // namespace welding_demo
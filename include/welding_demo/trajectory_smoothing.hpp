@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit_msgs/msg/robot_trajectory.hpp>
+
+namespace welding_demo
+{
+// Removes the small joint oscillations that Cartesian IK at a fixed eef_step tends to produce.
+//
+// Joint positions are filtered with a Savitzky-Golay filter (a moving least-squares polynomial
+// fit), applied to all joints and samples at once as a sum of shifted, weighted copies of the
+// position matrix. The cost is linear in the trajectory length. Every smoothed point is checked
+// with forward kinematics; where the tool would move away from the planned pose by more than the
+// allowed position or orientation deviation, the correction is scaled back towards the original
+// point.
+struct SmoothingOptions
+{
+  int half_window = 3;  // the filter window spans 2 * half_window + 1 samples
+  int order = 2;        // degree of the fitted polynomial
+  double max_tcp_deviation = 5e-4;  // m
+  double max_orientation_deviation = 0.01;  // rad
+};
+
+struct SmoothingResult
+{
+  double max_tcp_deviation = 0.0;
+  double max_orientation_deviation = 0.0;
+  std::size_t limited_points = 0;  // points whose correction had to be scaled back
+};
+
+// Convolution weights of a Savitzky-Golay smoothing filter
+Eigen::VectorXd savitzkyGolayCoefficients(int half_window, int order);
+
+// Filter the rows of ``positions`` (one row per sample). The first and last ``half_window`` rows
+// are left unchanged, so the start and end of the path are kept exactly.
+Eigen::MatrixXd filterRows(const Eigen::MatrixXd& positions, const Eigen::VectorXd& coefficients);
+
+// Smooth ``trajectory`` in place. ``state`` is used as scratch space for forward kinematics of
+// ``tip``; velocities and accelerations are re-derived from the smoothed positions.
+SmoothingResult smoothTrajectory(moveit_msgs::msg::RobotTrajectory& trajectory,
+                                 moveit::core::RobotState& state,
+                                 const moveit::core::LinkModel* tip,
+                                 const SmoothingOptions& options = SmoothingOptions());
+}  // namespace welding_demo
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include <builtin_interfaces/msg/duration.hpp>
+
+namespace welding_demo
+{
+// Conversions between trajectory point times (time_from_start) and seconds
+inline double toSec(const builtin_interfaces::msg::Duration& d)
+{
+  return d.sec + d.nanosec * 1e-9;
+}
+
+inline builtin_interfaces::msg::Duration fromSec(double t)
+{
+  builtin_interfaces::msg::Duration d;
+  d.sec = static_cast<int32_t>(std::floor(t));
+  d.nanosec = static_cast<uint32_t>(std::round((t - d.sec) * 1e9));
+  if (d.nanosec >= 1000000000u)
+  {
+    ++d.sec;
+    d.nanosec -= 1000000000u;
+  }
+  return d;
+}
+}  // namespace welding_demo
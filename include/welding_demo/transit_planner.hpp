@@ -0,0 +1,103 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Geometry>
+#include <geometry_msgs/msg/pose.hpp>
+#include <moveit/move_group_interface/move_group_interface.h>
+#include <moveit_msgs/msg/robot_trajectory.hpp>
+
+namespace welding_demo
+{
+// Seam pose moved by ``distance`` along its surface normal (seamNormal()), which backs the torch
+// off the workpiece. The orientation is kept.
+geometry_msgs::msg::Pose offsetAlongSeamNormal(const geometry_msgs::msg::Pose& pose,
+                                               double distance);
+
+// Prepend the approach pose and append the retract pose of a seam to its waypoints, so the
+// approach and retract segments are planned as part of the Cartesian path
+void addApproachAndRetract(std::vector<geometry_msgs::msg::Pose>& waypoints,
+                           double approach_distance, double retract_distance);
+
+// Time-reversed copy of a joint trajectory: positions in reverse order, velocities negated
+void reverseTrajectory(const moveit_msgs::msg::RobotTrajectory& in,
+                       moveit_msgs::msg::RobotTrajectory& out);
+
+// Roadmap of joint-space transit plans between frequently visited configurations (home, seam
+// approach poses, ...). Configurations closer than the joint tolerance share a node, every planned
+// transit is stored as an edge and is also served in the opposite direction. The roadmap can be
+// saved and reloaded, so it is reused across parts and restarts.
+class TransitRoadmap
+{
+public:
+  explicit TransitRoadmap(double joint_tolerance = 0.01) : joint_tolerance_(joint_tolerance)
+  {
+  }
+
+  // Node matching the configuration, or -1
+  int findNode(const std::vector<double>& positions) const;
+  std::size_t addNode(const std::vector<double>& positions);
+
+  bool lookup(const std::vector<double>& start, const std::vector<double>& goal,
+              moveit_msgs::msg::RobotTrajectory& trajectory) const;
+  void insert(const std::vector<double>& start, const std::vector<double>& goal,
+              const moveit_msgs::msg::RobotTrajectory& trajectory);
+  // Insert a stored plan, start and goal are taken from its first and last point. The plan is
+  // reordered from its own joint order to ``joint_names``, the order of the roadmap configurations
+  // (the planning group's variables). Returns false for plans lacking one of the joints.
+  bool insert(const moveit_msgs::msg::RobotTrajectory& trajectory,
+              const std::vector<std::string>& joint_names);
+
+  std::size_t nodeCount() const
+  {
+    return nodes_.size();
+  }
+  std::size_t edgeCount() const
+  {
+    return edges_.size();
+  }
+
+  bool save(const std::string& path) const;
+  bool load(const std::string& path);
+
+private:
+  double joint_tolerance_;
+  std::vector<std::vector<double>> nodes_;
+  std::map<std::pair<std::size_t, std::size_t>, moveit_msgs::msg::RobotTrajectory> edges_;
+};
+
+// Plans joint-space air moves through move_group, answering repeated requests from the roadmap
+class TransitPlanner
+{
+public:
+  TransitPlanner(moveit::planning_interface::MoveGroupInterface& move_group,
+                 double joint_tolerance = 0.01);
+
+  // Plan a transit from ``start`` to ``goal`` (positions of the planning group's active joints)
+  bool plan(const std::vector<double>& start, const std::vector<double>& goal,
+            moveit_msgs::msg::RobotTrajectory& trajectory, bool* cache_hit = nullptr);
+
+  TransitRoadmap& roadmap()
+  {
+    return roadmap_;
+  }
+
+  std::size_t hits() const
+  {
+    return hits_;
+  }
+  std::size_t misses() const
+  {
+    return misses_;
+  }
+
+private:
+  moveit::planning_interface::MoveGroupInterface& move_group_;
+  TransitRoadmap roadmap_;
+  std::size_t hits_ = 0;
+  std::size_t misses_ = 0;
+};
+}  // namespace welding_demo
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace welding_demo
+{
+struct TriangleMesh
+{
+  std::vector<Eigen::Vector3f> vertices;
+  std::vector<Eigen::Vector3i> triangles;
+
+  // Unit normal of a triangle, following the winding order
+  Eigen::Vector3f faceNormal(std::size_t triangle) const;
+};
+
+// Loads STL (ASCII or binary), OBJ (vertices and faces, polygons are fanned into triangles) or
+// PLY (ASCII or binary little-endian) by file extension. Vertices are scaled by ``scale``, CAD
+// exports are often in millimeters.
+bool loadMesh(const std::string& path, TriangleMesh& mesh, float scale = 1.0f);
+
+// ``count`` points spread uniformly over the surface of the mesh, one column per point. The
+// sampling is seeded, the same mesh always gives the same points.
+Eigen::Matrix3Xf sampleSurface(const TriangleMesh& mesh, std::size_t count);
+
+// Bounding volume hierarchy over the triangles of a mesh for closest point queries. Nodes are
+// split at the median of their longest axis and stored depth-first in one array, the second
+// child of a node directly follows the subtree of the first. Queries are const and can run in
+// parallel.
+class MeshBvh
+{
+public:
+  explicit MeshBvh(const TriangleMesh& mesh);
+
+  struct Hit
+  {
+    Eigen::Vector3f point;
+    std::size_t triangle = 0;
+    float distance = 0.0f;
+  };
+
+  // Closest point of the mesh to ``query``, false for an empty mesh
+  bool closestPoint(const Eigen::Vector3f& query, Hit& hit) const;
+
+  // Triangles with a point within ``radius`` of ``center``
+  void trianglesWithin(const Eigen::Vector3f& center, float radius,
+                       std::vector<std::size_t>& triangles) const;
+
+  const TriangleMesh& mesh() const
+  {
+    return mesh_;
+  }
+
+private:
+  struct Node
+  {
+    Eigen::AlignedBox3f bounds;
+    uint32_t first;  // leaf: first entry in order_, inner node: index of the second child
+    uint32_t count;  // triangles of a leaf, 0 for inner nodes
+  };
+
+  uint32_t build(uint32_t begin, uint32_t end, std::vector<Eigen::AlignedBox3f>& boxes,
+                 std::vector<Eigen::Vector3f>& centroids);
+
+  const TriangleMesh& mesh_;
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> order_;  // triangle indices, grouped by leaf
+};
+
+// Closest point on a triangle to ``p`` (Ericson, Real-Time Collision Detection, 5.1.5)
+Eigen::Vector3f closestPointOnTriangle(const Eigen::Vector3f& p, const Eigen::Vector3f& a,
+                                       const Eigen::Vector3f& b, const Eigen::Vector3f& c);
+}  // namespace welding_demo
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/msg/joint_state.hpp>
+#include <warehouse_ros/database_connection.h>
+
+#include <welding_demo/plan_store.hpp>
+
+namespace welding_demo
+{
+// PlanStore backed by warehouse_ros (the MongoDB instance started by the launch file). The
+// database plugin, host and port are taken from the usual warehouse_plugin, warehouse_host and
+// warehouse_port parameters of the node.
+class WarehousePlanStore : public PlanStore
+{
+public:
+  explicit WarehousePlanStore(const rclcpp::Node::SharedPtr& node,
+                              const std::string& database = "welding_demo");
+
+  bool connected() const
+  {
+    return static_cast<bool>(trajectories_);
+  }
+
+  bool storeTrajectory(const std::string& kind, uint64_t key,
+                       const moveit_msgs::msg::RobotTrajectory& trajectory) override;
+  bool loadTrajectory(const std::string& kind, uint64_t key,
+                      moveit_msgs::msg::RobotTrajectory& trajectory) override;
+  std::size_t
+  loadTrajectories(const std::string& kind,
+                   std::vector<moveit_msgs::msg::RobotTrajectory>& trajectories) override;
+
+  bool storeSeed(uint64_t key, const std::vector<double>& positions) override;
+  bool loadSeed(uint64_t key, std::vector<double>& positions) override;
+
+private:
+  warehouse_ros::DatabaseConnection::Ptr connection_;
+  warehouse_ros::MessageCollection<moveit_msgs::msg::RobotTrajectory>::Ptr trajectories_;
+  warehouse_ros::MessageCollection<sensor_msgs::msg::JointState>::Ptr seeds_;
+};
+}  // namespace welding_demo
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <geometry_msgs/msg/pose.hpp>
+#include <moveit/robot_state/robot_state.h>
+#include <moveit_msgs/msg/robot_trajectory.hpp>
+
+namespace welding_demo
+{
+// Periodic torch motion on top of the seam path.
+//
+// Offsets are expressed in the seam frame: ``lateral`` is across the seam (normal x tangent),
+// ``longitudinal`` along the tangent and ``normal`` along the seam normal (seamNormal()). The
+// phase advances with the arc length, so the pattern is independent of the welding speed.
+enum class WeavePattern
+{
+  NONE,
+  ZIGZAG,    // lateral triangle wave
+  TRIANGLE,  // lateral triangle wave, lifting the torch at the seam center
+  CIRCULAR,  // lateral and longitudinal sine waves a quarter period apart
+};
+
+struct WeaveParameters
+{
+  WeavePattern pattern = WeavePattern::NONE;
+  double amplitude = 0.002;   // m
+  double wavelength = 0.01;   // m of seam per weave period
+  double samples_per_period = 16;
+};
+
+// Parse "none", "zigzag", "triangle" or "circular"; unknown names map to NONE
+WeavePattern weavePatternFromString(const std::string& name);
+
+// Weave offsets of a batch of seam samples, one column per sample. Computed with whole-array
+// expressions so Eigen vectorizes them. Samples moving along the seam normal (approach, retract)
+// get no offset, and the weave fades in and out over half a wavelength at both ends of the weld,
+// so the first and last sample stay on the plain path.
+Eigen::Matrix3Xd weaveOffsets(const Eigen::VectorXd& arc_length, const Eigen::Matrix3Xd& tangents,
+                              const Eigen::Matrix3Xd& normals, const WeaveParameters& parameters);
+
+// Planning-layer weave: resample the seam spline through the waypoints densely enough for the
+// pattern and overlay the offsets. The seam normal is taken from the spline orientation.
+void applyWeave(std::vector<geometry_msgs::msg::Pose>& waypoints,
+                const WeaveParameters& parameters);
+
+// Execution-layer weave: resample an already planned trajectory at ``period`` and map the weave
+// offsets to joint corrections through the damped Jacobian pseudo-inverse. The Cartesian planner
+// only ever sees the plain seam, so weaving adds no planning time.
+//
+// The woven trajectory keeps the planned timing if it stays within the joint velocity and
+// acceleration limits. Otherwise it is re-timed with time-optimal trajectory generation and, if
+// that finishes sooner than planned, slowed down uniformly to the planned duration. A weave that
+// leaves the joint position limits or cannot be re-timed is rejected: false is returned and
+// ``trajectory`` is left unchanged.
+bool applyWeave(moveit_msgs::msg::RobotTrajectory& trajectory, moveit::core::RobotState& state,
+                const moveit::core::JointModelGroup* group, const moveit::core::LinkModel* tip,
+                const WeaveParameters& parameters, double period);
+}  // namespace welding_demo
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <rclcpp/rclcpp.hpp>
+
+#include <welding_demo/cad_seam_import.hpp>
+#include <welding_demo/closed_seam_sampling.hpp>
+#include <welding_demo/cloud_preprocessing.hpp>
+#include <welding_demo/multi_pass_planner.hpp>
+#include <welding_demo/scan_registration.hpp>
+#include <welding_demo/seam_extraction.hpp>
+#include <welding_demo/trajectory_smoothing.hpp>
+#include <welding_demo/weave_pattern.hpp>
+
+namespace welding_demo
+{
+// Node configuration. Every field is backed by a ROS parameter of the same name; the fields
+// below ``Derived values`` are computed from the others whenever the configuration changes.
+struct WeldingConfig
+{
+  // Read at startup, changing them requires a restart
+  std::string planning_group = "ur_manipulator";
+  std::string reachability_map;
+  std::string transit_roadmap;
+  double transit_joint_tolerance = 0.01;
+  std::string plan_store = "warehouse";  // warehouse, file or none
+  std::string plan_store_file = "welding_plans.log";
+  double compression_tolerance = 0.0;  // rad, 0 stores plans uncompressed
+  double decompression_period = 0.01;
+  bool profile_startup = false;
+  std::string planning_mode = "move_group";  // move_group or local (in process)
+  std::string cloud_buffer;  // shared memory cloud buffer, empty to disable
+  std::string part_mesh;  // CAD mesh of the part (STL, OBJ or PLY)
+  std::string part_seams;  // seam curves on the part mesh
+  double part_mesh_scale = 1.0;  // 0.001 for meshes in millimeters
+  // FollowJointTrajectory action of the arm controller. Trajectories are then executed without
+  // blocking the demo loop; empty executes them through move_group, waiting for every motion.
+  std::string execution_action;
+
+  // Applied from the next cycle on
+  std::string fixture_id = "default";
+  std::vector<double> circle_center = { 0.2, 0.0, 0.8 };
+  double circle_radius = 0.2;
+  double circle_angle_step = 0.5;  // largest angle between circle waypoints
+  int circle_points = 0;  // waypoints around the circle, 0 derives them from circle_angle_step
+  double circle_overlap = 0.0;  // m welded past the circle start, negative leaves a gap
+  double eef_step = 0.01;
+  double jump_threshold = 0.0;
+  double min_manipulability = 0.0;
+  double approach_distance = 0.05;
+  double retract_distance = 0.05;
+  int smoothing_half_window = 3;
+  int smoothing_order = 2;
+  double max_tcp_deviation = 5e-4;
+  double max_orientation_deviation = 0.01;
+  std::string weave_pattern = "none";
+  double weave_amplitude = 0.002;
+  double weave_wavelength = 0.01;
+  std::string weave_layer = "execute";  // plan or execute
+  double weave_period = 0.004;
+  std::vector<double> pass_lateral_offsets;
+  std::vector<double> pass_lifts;
+  std::vector<double> roi_min = { -1.0, -1.0, 0.0 };  // scan crop box, in the scan frame
+  std::vector<double> roi_max = { 1.0, 1.0, 2.0 };
+  double voxel_size = 0.002;  // scan downsampling, 0 to disable
+  std::string seam_source = "circle";  // circle, scan or cad
+  std::vector<double> part_pose = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };  // x y z roll pitch yaw
+  bool register_part = false;  // correct part_pose by aligning the scan to the part mesh
+  double registration_max_distance = 0.02;
+  int registration_iterations = 30;
+  double plane_distance_threshold = 0.002;
+  int max_planes = 8;
+  double seam_sample_step = 0.01;
+  double min_seam_length = 0.03;
+  double max_butt_gap = 0.006;  // widest gap between coplanar plates taken as a seam, 0: none
+  double seam_spline_step = 0.0;  // resample seams along their spline, 0 keeps the waypoints
+
+  // Derived values
+  Eigen::Vector3d center = Eigen::Vector3d(0.2, 0.0, 0.8);
+  ClosedSeamSampling circle_sampling;
+  SmoothingOptions smoothing;
+  WeaveParameters weave;
+  bool weave_at_execution = true;
+  std::vector<PassOffset> pass_offsets;
+  PreprocessingOptions preprocessing;
+  SeamExtractionOptions seam_extraction;
+  Eigen::Isometry3d part_transform = Eigen::Isometry3d::Identity();
+  CadSeamOptions cad_seams;
+  RegistrationOptions registration;
+
+  // Cross-parameter checks, returns an empty string or the reason the configuration is invalid
+  std::string validate() const;
+  void updateDerived();
+};
+
+using WeldingConfigConstPtr = std::shared_ptr<const WeldingConfig>;
+
+// Declares the configuration parameters, keeps the current configuration and applies parameter
+// updates at runtime. An update is validated as a whole and either accepted, in which case the
+// configuration is swapped atomically, or rejected with the reason. Readers take a snapshot with
+// ``get()`` and keep a consistent configuration for as long as they hold it. Invalid values given
+// at startup are replaced by their defaults, in the configuration and in the parameters.
+class WeldingConfigServer
+{
+public:
+  explicit WeldingConfigServer(const rclcpp::Node::SharedPtr& node);
+
+  WeldingConfigConstPtr get() const
+  {
+    return std::atomic_load(&config_);
+  }
+
+private:
+  rcl_interfaces::msg::SetParametersResult
+  onSetParameters(const std::vector<rclcpp::Parameter>& parameters);
+
+  WeldingConfigConstPtr config_;
+  rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr callback_handle_;
+};
+}  // namespace welding_demo
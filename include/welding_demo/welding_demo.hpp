@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <rclcpp/rclcpp.hpp>
+#include <rviz_visual_tools/remote_control.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <trajectory_msgs/msg/joint_trajectory.hpp>
+
+#include <welding_demo/async_execution.hpp>
+
+namespace welding_demo
+{
+// The welding demo as an rclcpp component.
+//
+// It can run in its own process (welding_demo_node) or be loaded into a component container
+// together with the sensor drivers. With intra-process communication enabled, point clouds are
+// received and executed trajectories are published as unique_ptr messages, so they are handed
+// over between nodes of the same container without copies.
+//
+// The constructor returns right away, the demo loop runs in its own thread while the executor of
+// the process or container spins the node. The destructor and the shutdown of the context stop the
+// loop: a pending prompt returns, a motion in flight is canceled, and the loop ends before its
+// next step.
+class WeldingDemo
+{
+public:
+  explicit WeldingDemo(const rclcpp::NodeOptions& options);
+  ~WeldingDemo();
+
+  rclcpp::node_interfaces::NodeBaseInterface::SharedPtr get_node_base_interface() const
+  {
+    return node_->get_node_base_interface();
+  }
+
+  // Most recent point cloud from the "points" topic, or null
+  std::shared_ptr<const sensor_msgs::msg::PointCloud2> latestCloud() const;
+
+private:
+  void run();
+  // Stops the loop and cancels the motion in flight, while the context is still valid
+  void stop();
+  void onPointCloud(sensor_msgs::msg::PointCloud2::UniquePtr cloud);
+
+  rclcpp::Node::SharedPtr node_;
+  rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr cloud_subscription_;
+  rclcpp::Publisher<trajectory_msgs::msg::JointTrajectory>::SharedPtr trajectory_publisher_;
+  mutable std::mutex cloud_mutex_;
+  std::shared_ptr<const sensor_msgs::msg::PointCloud2> latest_cloud_;
+  std::mutex stop_mutex_;
+  std::atomic<bool> stop_{ false };
+  rviz_visual_tools::RemoteControlPtr remote_control_;  // of the loop's prompts, once created
+  ExecutionPtr in_flight_;  // the loop's motion in flight, for stop() to cancel
+  rclcpp::PreShutdownCallbackHandle pre_shutdown_;
+  std::thread thread_;
+};
+}  // namespace welding_demo
@@ -19,10 +19,60 @@ from launch.actions import DeclareLaunchArgument
 from launch.actions import OpaqueFunction
 from launch.conditions import IfCondition
 from launch.substitutions import Command, FindExecutable, LaunchConfiguration, PathJoinSubstitution
-from launch_ros.actions import Node
+from launch.utilities import normalize_to_list_of_substitutions, perform_substitutions
+from launch_ros.actions import ComposableNodeContainer, Node
+from launch_ros.descriptions import ComposableNode
 from launch_ros.substitutions import FindPackageShare
 from ur_bringup.launch_common import load_yaml, load_yaml_abs
 
+import hashlib
+import os
+import shlex
+import subprocess
+
+
+def package_fingerprint(package_path):
+    """Hash of the names, sizes and modification times of all files of an installed package."""
+    digest = hashlib.sha256()
+    for root, dirs, files in os.walk(package_path):
+        dirs.sort()
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            stat = os.stat(path)
+            digest.update(f"{path}:{stat.st_size}:{stat.st_mtime_ns}\n".encode())
+    return digest.hexdigest()
+
+
+def cached_xacro(context, command, packages, use_cache):
+    """
+    Run a xacro command, reusing the output of an identical earlier run.
+
+    Expanding the UR description takes seconds on every launch. The output only depends on the
+    command line and on the files of the packages it reads, so it is cached under a hash of both.
+    """
+    if not use_cache:
+        return Command(command)
+    command_line = perform_substitutions(context, normalize_to_list_of_substitutions(command))
+    digest = hashlib.sha256(command_line.encode())
+    for package in packages:
+        digest.update(package_fingerprint(FindPackageShare(package).perform(context)).encode())
+    cache_dir = os.path.join(
+            os.environ.get("XDG_CACHE_HOME", os.path.expanduser("~/.cache")), "welding_demo"
+            )
+    cache_file = os.path.join(cache_dir, digest.hexdigest() + ".xml")
+    if os.path.isfile(cache_file):
+        with open(cache_file) as f:
+            return f.read()
+    output = subprocess.run(
+            shlex.split(command_line), check=True, capture_output=True, text=True
+            ).stdout
+    os.makedirs(cache_dir, exist_ok=True)
+    # Write to a temporary file first, so concurrent launches never read a partial description
+    with open(cache_file + f".{os.getpid()}", "w") as f:
+        f.write(output)
+    os.replace(cache_file + f".{os.getpid()}", cache_file)
+    return output
+
 
 def launch_setup(context, *args, **kwargs):
 
@@ -43,6 +93,16 @@ def launch_setup(context, *args, **kwargs):
     launch_rviz = LaunchConfiguration("launch_rviz")
     launch_servo = LaunchConfiguration("launch_servo")
     headless_mode = LaunchConfiguration("headless_mode")
+    reachability_map = LaunchConfiguration("reachability_map")
+    plan_store = LaunchConfiguration("plan_store")
+    plan_store_file = LaunchConfiguration("plan_store_file")
+    use_xacro_cache = LaunchConfiguration("xacro_cache").perform(context).lower() == "true"
+    profile_startup = LaunchConfiguration("profile_startup")
+    planning_mode = LaunchConfiguration("planning_mode")
+    use_composition = LaunchConfiguration("use_composition")
+    cloud_buffer = LaunchConfiguration("cloud_buffer")
+    part_mesh = LaunchConfiguration("part_mesh")
+    part_seams = LaunchConfiguration("part_seams")
 
     joint_limit_params = PathJoinSubstitution(
             [FindPackageShare(description_package), "config", ur_type, "joint_limits.yaml"]
@@ -66,7 +126,7 @@ def launch_setup(context, *args, **kwargs):
             [FindPackageShare("ur_robot_driver"), "resources", "rtde_output_recipe.txt"]
             )
 
-    robot_description_content = Command(
+    robot_description_command = (
             [
                 PathJoinSubstitution([FindExecutable(name="xacro")]),
                 " ",
@@ -124,10 +184,13 @@ def launch_setup(context, *args, **kwargs):
             " ",
         ]
     )
+    robot_description_content = cached_xacro(
+            context, robot_description_command, [description_package], use_xacro_cache
+            )
     robot_description = {"robot_description": robot_description_content}
 
     # MoveIt Configuration
-    robot_description_semantic_content = Command(
+    robot_description_semantic_command = (
             [
                 PathJoinSubstitution([FindExecutable(name="xacro")]),
                 " ",
@@ -145,6 +208,9 @@ def launch_setup(context, *args, **kwargs):
                 " ",
                 ]
             )
+    robot_description_semantic_content = cached_xacro(
+            context, robot_description_semantic_command, [moveit_config_package], use_xacro_cache
+            )
     robot_description_semantic = {"robot_description_semantic": robot_description_semantic_content}
 
     kinematics_yaml = load_yaml("ur_moveit_config", "config/kinematics.yaml")
@@ -204,14 +270,15 @@ def launch_setup(context, *args, **kwargs):
             )
 
     # Warehouse mongodb server
+    warehouse_ros_config = {
+            "warehouse_port": 33829,
+            "warehouse_host": "localhost",
+            "warehouse_plugin": "warehouse_ros_mongo::MongoDatabaseConnection",
+            }
     mongodb_server_node = Node(
             package="warehouse_ros_mongo",
             executable="mongo_wrapper_ros.py",
-            parameters=[
-                {"warehouse_port": 33829},
-                {"warehouse_host": "localhost"},
-                {"warehouse_plugin": "warehouse_ros_mongo::MongoDatabaseConnection"},
-                ],
+            parameters=[warehouse_ros_config],
             output="screen",
             )
 
@@ -262,17 +329,53 @@ def launch_setup(context, *args, **kwargs):
     #            },
     #        )
     # Test Node for moving robot with code
+    welding_demo_parameters = [
+            robot_description,
+            robot_description_semantic,
+            kinematics_yaml,
+            warehouse_ros_config,
+            {"reachability_map": reachability_map},
+            {"plan_store": plan_store, "plan_store_file": plan_store_file},
+            {"profile_startup": profile_startup, "planning_mode": planning_mode},
+            {"cloud_buffer": cloud_buffer},
+            {"part_mesh": part_mesh, "part_seams": part_seams},
+            ]
     test_request_node = Node(
             package="welding_demo",
             executable="welding_demo_node",
             name="welding_demo",
             output="screen",
             # prefix=["xterm -e gdb -ex run --args"],
-            parameters=[robot_description, robot_description_semantic, kinematics_yaml],
+            parameters=welding_demo_parameters,
             #parameters=[robot_description, robot_description_semantic],
             )
 
-    nodes_to_start = [move_group_node, mongodb_server_node, rviz_node, static_tf, test_request_node]
+    # The same node as a component. Sensor drivers loaded into this container pass their clouds
+    # to it intra-process, without copies.
+    welding_container = ComposableNodeContainer(
+            name="welding_container",
+            namespace="",
+            package="rclcpp_components",
+            executable="component_container_mt",
+            composable_node_descriptions=[
+                ComposableNode(
+                    package="welding_demo",
+                    plugin="welding_demo::WeldingDemo",
+                    name="welding_demo",
+                    parameters=welding_demo_parameters,
+                    extra_arguments=[{"use_intra_process_comms": True}],
+                    ),
+                ],
+            output="screen",
+            )
+
+    welding_node = test_request_node
+    if use_composition.perform(context) == "true":
+        welding_node = welding_container
+    nodes_to_start = [move_group_node, rviz_node, static_tf, welding_node]
+    # The embedded file store does not need the database process
+    if plan_store.perform(context) == "warehouse":
+        nodes_to_start.append(mongodb_server_node)
 
     return nodes_to_start
 
@@ -376,6 +479,78 @@ def generate_launch_description():
                 description="Enable headless mode for robot control",
                 )
             )
+    declared_arguments.append(
+            DeclareLaunchArgument(
+                "reachability_map",
+                default_value="",
+                description="Precomputed reachability map used to reject unreachable seams.",
+                )
+            )
+    declared_arguments.append(
+            DeclareLaunchArgument(
+                "plan_store",
+                default_value="warehouse",
+                description="Storage of computed plans: warehouse (MongoDB), file or none.",
+                choices=["warehouse", "file", "none"],
+                )
+            )
+    declared_arguments.append(
+            DeclareLaunchArgument(
+                "plan_store_file",
+                default_value="welding_plans.log",
+                description="Log file of the embedded plan store, used with plan_store:=file.",
+                )
+            )
+    declared_arguments.append(
+            DeclareLaunchArgument(
+                "cloud_buffer",
+                default_value="",
+                description="Shared memory buffer to read scans from (see cloud_replay).",
+                )
+            )
+    declared_arguments.append(
+            DeclareLaunchArgument(
+                "part_mesh",
+                default_value="",
+                description="CAD mesh of the part (STL, OBJ or PLY) to take seams from.",
+                )
+            )
+    declared_arguments.append(
+            DeclareLaunchArgument(
+                "part_seams",
+                default_value="",
+                description="Seam curves on the part mesh, one 'seam <name>' block per seam.",
+                )
+            )
+    declared_arguments.append(
+            DeclareLaunchArgument(
+                "use_composition",
+                default_value="false",
+                description="Load the welding node as a component into a container.",
+                )
+            )
+    declared_arguments.append(
+            DeclareLaunchArgument(
+                "planning_mode",
+                default_value="move_group",
+                description="Plan Cartesian paths through move_group or in the welding node.",
+                choices=["move_group", "local"],
+                )
+            )
+    declared_arguments.append(
+            DeclareLaunchArgument(
+                "xacro_cache",
+                default_value="true",
+                description="Reuse the expanded robot descriptions of earlier launches.",
+                )
+            )
+    declared_arguments.append(
+            DeclareLaunchArgument(
+                "profile_startup",
+                default_value="false",
+                description="Log a per-phase breakdown of the welding node startup time.",
+                )
+            )
     declared_arguments.append(
             DeclareLaunchArgument("launch_rviz", default_value="true", description="Launch RViz?")
             )
@@ -0,0 +1,27 @@
+#include <welding_demo/allocation_counter.hpp>
+
+#include <atomic>
+
+namespace welding_demo
+{
+namespace
+{
+std::atomic<std::uint64_t> heap_allocations{ 0 };
+}  // namespace
+
+std::uint64_t heapAllocations()
+{
+  return heap_allocations.load(std::memory_order_relaxed);
+}
+
+bool countingHeapAllocations()
+{
+  // With the counting operator new the process has allocated long before anyone asks
+  return heapAllocations() > 0;
+}
+
+void countHeapAllocation()
+{
+  heap_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+}  // namespace welding_demo
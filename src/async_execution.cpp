@@ -0,0 +1,214 @@
+#include <welding_demo/async_execution.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+#include <rclcpp/duration.hpp>
+
+namespace welding_demo
+{
+Execution::State Execution::state() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return state_;
+}
+
+bool Execution::done() const
+{
+  const State current = state();
+  return current != State::PENDING && current != State::ACTIVE;
+}
+
+ExecutionProgress Execution::progress() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return progress_;
+}
+
+bool Execution::wait(std::chrono::milliseconds timeout) const
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto finished = [this]() { return state_ != State::PENDING && state_ != State::ACTIVE; };
+  if (timeout == std::chrono::milliseconds::max())
+  {
+    finished_.wait(lock, finished);
+    return true;
+  }
+  return finished_.wait_for(lock, timeout, finished);
+}
+
+void Execution::cancel()
+{
+  GoalHandle::SharedPtr goal_handle;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancel_requested_ = true;  // a goal that is still pending is canceled once accepted
+    goal_handle = goal_handle_;
+  }
+  const auto client = client_.lock();
+  if (goal_handle && client)
+    client->async_cancel_goal(goal_handle);
+}
+
+void Execution::finish(State state)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_ = state;
+    goal_handle_.reset();
+    if (state == State::SUCCEEDED)
+    {
+      progress_.point = point_times_.empty() ? 0 : point_times_.size() - 1;
+      progress_.arc_length = progress_.total_length;
+      progress_.waypoint = waypoint_lengths_.empty() ? 0 : waypoint_lengths_.size() - 1;
+    }
+  }
+  finished_.notify_all();
+}
+
+AsyncExecutor::AsyncExecutor(const rclcpp::Node::SharedPtr& node, const std::string& action_name)
+  : logger_(node->get_logger().get_child("async_executor"))
+  , client_(rclcpp_action::create_client<Action>(node, action_name))
+{
+}
+
+ExecutionPtr AsyncExecutor::execute(const moveit_msgs::msg::RobotTrajectory& trajectory,
+                                    std::vector<double> point_lengths,
+                                    std::vector<double> waypoint_lengths)
+{
+  auto execution = std::make_shared<Execution>();
+  const auto& jt = trajectory.joint_trajectory;
+  execution->client_ = client_;
+  execution->joint_names_ = jt.joint_names;
+  if (!jt.points.empty())
+    execution->final_positions_ = jt.points.back().positions;
+  execution->point_times_.reserve(jt.points.size());
+  for (const auto& point : jt.points)
+    execution->point_times_.push_back(rclcpp::Duration(point.time_from_start).seconds());
+  execution->point_lengths_ = std::move(point_lengths);
+  execution->waypoint_lengths_ = std::move(waypoint_lengths);
+  execution->progress_.total_length =
+      execution->point_lengths_.empty() ? 0.0 : execution->point_lengths_.back();
+
+  if (jt.points.empty() || !client_->action_server_is_ready())
+  {
+    RCLCPP_WARN(logger_, "%s",
+                jt.points.empty() ? "Empty trajectory, nothing to execute" :
+                                    "No trajectory controller available");
+    execution->finish(Execution::State::REJECTED);
+    return execution;
+  }
+
+  // The callbacks hold the execution weakly, an abandoned execution is not kept alive by them
+  const std::weak_ptr<Execution> weak = execution;
+  rclcpp_action::Client<Action>::SendGoalOptions options;
+  options.goal_response_callback = [weak](Execution::GoalHandle::SharedPtr goal_handle) {
+    const auto execution = weak.lock();
+    if (!execution)
+      return;
+    if (!goal_handle)
+    {
+      execution->finish(Execution::State::REJECTED);
+      return;
+    }
+    bool cancel = false;
+    {
+      std::lock_guard<std::mutex> lock(execution->mutex_);
+      execution->goal_handle_ = goal_handle;
+      execution->state_ = Execution::State::ACTIVE;
+      cancel = execution->cancel_requested_;
+    }
+    if (cancel)
+      execution->cancel();
+  };
+  options.feedback_callback = [weak](Execution::GoalHandle::SharedPtr,
+                                     const std::shared_ptr<const Action::Feedback> feedback) {
+    const auto execution = weak.lock();
+    if (!execution || execution->point_times_.empty())
+      return;
+    // The point the controller is interpolating towards, from the desired time from start
+    const double time = rclcpp::Duration(feedback->desired.time_from_start).seconds();
+    const auto& times = execution->point_times_;
+    const auto point = static_cast<std::size_t>(
+        std::max<std::ptrdiff_t>(0, std::upper_bound(times.begin(), times.end(), time) -
+                                        times.begin() - 1));
+    std::lock_guard<std::mutex> lock(execution->mutex_);
+    ExecutionProgress& progress = execution->progress_;
+    progress.point = std::max(progress.point, point);
+    if (progress.point < execution->point_lengths_.size())
+      progress.arc_length = execution->point_lengths_[progress.point];
+    // The tool path includes the weave, the waypoints are along the plain seam: the waypoint is
+    // looked up at the same fraction of the seam length
+    const auto& lengths = execution->waypoint_lengths_;
+    if (!lengths.empty() && progress.total_length > 0.0)
+    {
+      const double seam_length = progress.arc_length / progress.total_length * lengths.back();
+      progress.waypoint = static_cast<std::size_t>(
+          std::upper_bound(lengths.begin(), lengths.end(), seam_length) - lengths.begin() - 1);
+    }
+  };
+  options.result_callback =
+      [weak](const rclcpp_action::ClientGoalHandle<Action>::WrappedResult& result) {
+        const auto execution = weak.lock();
+        if (!execution)
+          return;
+        switch (result.code)
+        {
+          case rclcpp_action::ResultCode::SUCCEEDED:
+            execution->finish(result.result && result.result->error_code != 0 ?
+                                  Execution::State::ABORTED :
+                                  Execution::State::SUCCEEDED);
+            break;
+          case rclcpp_action::ResultCode::CANCELED:
+            execution->finish(Execution::State::CANCELED);
+            break;
+          default:
+            execution->finish(Execution::State::ABORTED);
+            break;
+        }
+      };
+
+  Action::Goal goal;
+  goal.trajectory = jt;
+  goal.trajectory.header.stamp = rclcpp::Time(0, 0, RCL_ROS_TIME);  // start right away
+  client_->async_send_goal(goal, options);
+  return execution;
+}
+
+std::vector<double> toolPathLengths(const moveit_msgs::msg::RobotTrajectory& trajectory,
+                                    moveit::core::RobotState& state,
+                                    const moveit::core::LinkModel* tip)
+{
+  const auto& jt = trajectory.joint_trajectory;
+  std::vector<double> lengths;
+  lengths.reserve(jt.points.size());
+  Eigen::Vector3d previous = Eigen::Vector3d::Zero();
+  for (const auto& point : jt.points)
+  {
+    state.setVariablePositions(jt.joint_names, point.positions);
+    state.updateLinkTransforms();
+    const Eigen::Vector3d position = state.getGlobalLinkTransform(tip).translation();
+    lengths.push_back(lengths.empty() ? 0.0 : lengths.back() + (position - previous).norm());
+    previous = position;
+  }
+  return lengths;
+}
+
+std::vector<double> waypointPathLengths(const std::vector<geometry_msgs::msg::Pose>& waypoints)
+{
+  std::vector<double> lengths;
+  lengths.reserve(waypoints.size());
+  for (std::size_t i = 0; i < waypoints.size(); ++i)
+  {
+    if (i == 0)
+    {
+      lengths.push_back(0.0);
+      continue;
+    }
+    const auto& a = waypoints[i - 1].position;
+    const auto& b = waypoints[i].position;
+    lengths.push_back(lengths.back() + Eigen::Vector3d(b.x - a.x, b.y - a.y, b.z - a.z).norm());
+  }
+  return lengths;
+}
+}  // namespace welding_demo
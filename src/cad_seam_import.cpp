@@ -0,0 +1,150 @@
+#include <welding_demo/cad_seam_import.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace welding_demo
+{
+namespace
+{
+// Face normals closer than about 3 degrees are treated as one surface direction
+constexpr float SAME_DIRECTION = 0.9986f;
+}  // namespace
+
+bool loadSeamCurves(const std::string& path, std::vector<SeamCurve>& curves, float scale)
+{
+  std::ifstream in(path);
+  if (!in)
+    return false;
+  std::string line;
+  while (std::getline(in, line))
+  {
+    std::istringstream fields(line);
+    std::string first;
+    if (!(fields >> first) || first[0] == '#')
+      continue;
+    if (first == "seam")
+    {
+      curves.emplace_back();
+      fields >> curves.back().name;
+      if (curves.back().name.empty())
+        curves.back().name = "seam" + std::to_string(curves.size() - 1);
+      continue;
+    }
+    Eigen::Vector3f point;
+    std::istringstream coordinates(line);
+    if (curves.empty() || !(coordinates >> point.x() >> point.y() >> point.z()))
+      return false;
+    curves.back().points.push_back(point * scale);
+  }
+  return true;
+}
+
+void sampleCadSeams(const MeshBvh& bvh, const std::vector<SeamCurve>& curves,
+                    const Eigen::Isometry3d& part_pose, const CadSeamOptions& options,
+                    SeamBuffer& seams)
+{
+  // Resample the polylines at a fixed arc length step, the curve endpoints are always kept
+  std::vector<Eigen::Vector3f> samples;
+  std::vector<std::size_t> first_sample(curves.size() + 1, 0);
+  for (std::size_t c = 0; c < curves.size(); ++c)
+  {
+    first_sample[c] = samples.size();
+    const auto& points = curves[c].points;
+    if (points.size() < 2)
+      continue;
+    float length = 0.0f;
+    for (std::size_t i = 1; i < points.size(); ++i)
+      length += (points[i] - points[i - 1]).norm();
+    const auto count = std::max<std::size_t>(
+        2, static_cast<std::size_t>(std::lround(length / options.sample_step)) + 1);
+    std::size_t segment = 1;
+    float segment_start = 0.0f;
+    for (std::size_t k = 0; k < count; ++k)
+    {
+      const float s = length * k / (count - 1);
+      float segment_length = (points[segment] - points[segment - 1]).norm();
+      while (segment + 1 < points.size() && s > segment_start + segment_length)
+      {
+        segment_start += segment_length;
+        ++segment;
+        segment_length = (points[segment] - points[segment - 1]).norm();
+      }
+      const float u =
+          segment_length > 0.0f ? std::min(1.0f, (s - segment_start) / segment_length) : 0.0f;
+      samples.push_back(points[segment - 1] + u * (points[segment] - points[segment - 1]));
+    }
+  }
+  first_sample[curves.size()] = samples.size();
+
+  // Project every sample and estimate its normal, in parallel over all curves
+  const TriangleMesh& mesh = bvh.mesh();
+  std::vector<Eigen::Vector3f> positions(samples.size());
+  std::vector<Eigen::Vector3f> normals(samples.size());
+  std::vector<unsigned char> valid(samples.size(), 0);
+  auto work = [&](std::size_t begin, std::size_t end) {
+    std::vector<std::size_t> nearby;
+    std::vector<Eigen::Vector3f> directions;
+    MeshBvh::Hit hit;
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      if (!bvh.closestPoint(samples[i], hit) || hit.distance > options.max_projection_distance)
+        continue;
+      bvh.trianglesWithin(hit.point, options.normal_radius, nearby);
+      // Every surface direction counts once, however finely its face happens to be tessellated
+      directions.clear();
+      for (std::size_t t : nearby)
+      {
+        const Eigen::Vector3f n = mesh.faceNormal(t);
+        if (n.allFinite() &&
+            std::none_of(directions.begin(), directions.end(),
+                         [&n](const Eigen::Vector3f& d) { return d.dot(n) > SAME_DIRECTION; }))
+          directions.push_back(n);
+      }
+      Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+      for (const Eigen::Vector3f& d : directions)
+        normal += d;
+      if (normal.squaredNorm() < 1e-12f)
+        normal = mesh.faceNormal(hit.triangle);
+      positions[i] = hit.point;
+      normals[i] = normal.normalized();
+      valid[i] = 1;
+    }
+  };
+  const std::size_t threads = std::max<std::size_t>(
+      1, std::min(options.threads > 0 ? options.threads :
+                                        std::max(1u, std::thread::hardware_concurrency()),
+                  samples.size() / 64));
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < threads; ++t)
+    workers.emplace_back(work, samples.size() * t / threads, samples.size() * (t + 1) / threads);
+  work(0, samples.size() / threads);
+  for (auto& worker : workers)
+    worker.join();
+
+  PoseBatch poses;
+  Vector3Batch surface_normals;
+  for (std::size_t c = 0; c < curves.size(); ++c)
+  {
+    Eigen::Index count = 0;
+    for (std::size_t i = first_sample[c]; i < first_sample[c + 1]; ++i)
+      count += valid[i];
+    if (count < 2)
+      continue;
+    poses.resize(count);
+    surface_normals.resize(3, count);
+    Eigen::Index column = 0;
+    for (std::size_t i = first_sample[c]; i < first_sample[c + 1]; ++i)
+      if (valid[i])
+      {
+        poses.positions.col(column) = part_pose * positions[i].cast<double>();
+        surface_normals.col(column++) = part_pose.linear() * normals[i].cast<double>();
+      }
+    seamOrientations(surface_normals, poses.orientations);
+    seams.add(curves[c].name, poses);
+  }
+}
+}  // namespace welding_demo
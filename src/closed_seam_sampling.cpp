@@ -0,0 +1,47 @@
+#include <welding_demo/closed_seam_sampling.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace welding_demo
+{
+std::vector<double> closedSeamPositions(double perimeter, const ClosedSeamSampling& sampling)
+{
+  std::vector<double> positions;
+  if (!(perimeter > 0.0))
+    return positions;
+  std::size_t count = sampling.count;
+  if (count == 0)
+    count = sampling.max_spacing > 0.0 ?
+                static_cast<std::size_t>(std::ceil(perimeter / sampling.max_spacing - 1e-9)) :
+                1;
+  count = std::max<std::size_t>(count, 3);  // fewer points do not enclose anything
+  const double spacing = perimeter / static_cast<double>(count);
+  const double end = std::max(0.0, perimeter + sampling.overlap);
+  // Number of even steps of at most ``spacing`` over ``length``, ignoring rounding noise
+  auto steps = [spacing](double length) {
+    return std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(length / spacing - 1e-9)));
+  };
+
+  if (end < perimeter)
+  {
+    // A gap is left before the start point: the shortened seam is spaced evenly instead
+    const std::size_t n = steps(end);
+    for (std::size_t i = 0; i <= n; ++i)
+      positions.push_back(end * static_cast<double>(i) / static_cast<double>(n));
+    return positions;
+  }
+  // The start point recurs exactly at ``perimeter``, the overlap gets its own even steps
+  for (std::size_t i = 0; i < count; ++i)
+    positions.push_back(perimeter * static_cast<double>(i) / static_cast<double>(count));
+  positions.push_back(perimeter);
+  if (sampling.overlap > 0.0)
+  {
+    const std::size_t n = steps(sampling.overlap);
+    for (std::size_t i = 1; i <= n; ++i)
+      positions.push_back(perimeter +
+                          sampling.overlap * static_cast<double>(i) / static_cast<double>(n));
+  }
+  return positions;
+}
+}  // namespace welding_demo
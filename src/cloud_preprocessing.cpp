@@ -0,0 +1,191 @@
+#include <welding_demo/cloud_preprocessing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sensor_msgs/point_cloud2_iterator.hpp>
+
+namespace welding_demo
+{
+namespace
+{
+// Points per thread below which splitting the scan does not pay off
+constexpr std::size_t MIN_CHUNK = 65536;
+constexpr uint64_t EMPTY_KEY = ~0ull;
+constexpr int64_t KEY_BIAS = 1 << 20;  // 21 bits per axis
+constexpr uint64_t KEY_MASK = (1ull << 21) - 1;
+
+uint64_t voxelKey(float index)
+{
+  return static_cast<uint64_t>(static_cast<int64_t>(index) + KEY_BIAS) & KEY_MASK;
+}
+
+struct VoxelSum
+{
+  float x = 0.0f, y = 0.0f, z = 0.0f;
+  uint32_t count = 0;
+};
+
+// Open-addressing hash grid from packed voxel indices to point sums
+class VoxelGrid
+{
+public:
+  VoxelGrid() : keys_(1024, EMPTY_KEY), sums_(1024)
+  {
+  }
+
+  void add(uint64_t key, float x, float y, float z, uint32_t count = 1)
+  {
+    if (2 * (size_ + 1) > keys_.size())
+      grow();
+    VoxelSum& sum = sums_[probe(key)];
+    sum.x += x;
+    sum.y += y;
+    sum.z += z;
+    sum.count += count;
+  }
+
+  void mergeInto(VoxelGrid& other) const
+  {
+    for (std::size_t i = 0; i < keys_.size(); ++i)
+      if (keys_[i] != EMPTY_KEY)
+        other.add(keys_[i], sums_[i].x, sums_[i].y, sums_[i].z, sums_[i].count);
+  }
+
+  template <typename F>
+  void forEach(F f) const
+  {
+    for (std::size_t i = 0; i < keys_.size(); ++i)
+      if (keys_[i] != EMPTY_KEY)
+        f(sums_[i]);
+  }
+
+  std::size_t size() const
+  {
+    return size_;
+  }
+
+private:
+  static std::size_t hash(uint64_t key)
+  {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return static_cast<std::size_t>(key);
+  }
+
+  // Slot of ``key``, claimed if the key is new
+  std::size_t probe(uint64_t key)
+  {
+    const std::size_t mask = keys_.size() - 1;
+    std::size_t i = hash(key) & mask;
+    while (keys_[i] != key)
+    {
+      if (keys_[i] == EMPTY_KEY)
+      {
+        keys_[i] = key;
+        ++size_;
+        break;
+      }
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+
+  void grow()
+  {
+    std::vector<uint64_t> keys(keys_.size() * 2, EMPTY_KEY);
+    std::vector<VoxelSum> sums(sums_.size() * 2);
+    keys.swap(keys_);
+    sums.swap(sums_);
+    size_ = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+      if (keys[i] != EMPTY_KEY)
+        sums_[probe(keys[i])] = sums[i];
+  }
+
+  std::vector<uint64_t> keys_;
+  std::vector<VoxelSum> sums_;
+  std::size_t size_ = 0;
+};
+}  // namespace
+
+void cropAndDownsample(const Eigen::Ref<const Eigen::Matrix3Xf>& points,
+                       const PreprocessingOptions& options, Eigen::Matrix3Xf& out)
+{
+  const auto n = static_cast<std::size_t>(points.cols());
+  const bool crop = !options.roi.isEmpty();
+  const bool downsample = options.voxel_size > 0.0f;
+  const std::size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+  const std::size_t threads = std::max<std::size_t>(
+      1, std::min(options.threads > 0 ? options.threads : hardware, n / MIN_CHUNK));
+  const Eigen::Vector3f origin = crop ? options.roi.min() : Eigen::Vector3f::Zero();
+  const float inverse_size = downsample ? 1.0f / options.voxel_size : 0.0f;
+
+  if (!downsample)
+  {
+    // Crop only: compact the points inside the ROI
+    out.resize(3, points.cols());
+    Eigen::Index kept = 0;
+    for (Eigen::Index i = 0; i < points.cols(); ++i)
+      if (!crop || options.roi.contains(points.col(i)))
+        out.col(kept++) = points.col(i);
+    out.conservativeResize(3, kept);
+    return;
+  }
+
+  std::vector<VoxelGrid> grids(threads);
+  auto work = [&](std::size_t t) {
+    const std::size_t begin = n * t / threads;
+    const std::size_t end = n * (t + 1) / threads;
+    VoxelGrid& grid = grids[t];
+    for (std::size_t i = begin; i < end; ++i)
+    {
+      const auto p = points.col(static_cast<Eigen::Index>(i));
+      if (crop && !options.roi.contains(p))
+        continue;
+      const Eigen::Vector3f v = ((p - origin) * inverse_size).array().floor();
+      grid.add(voxelKey(v.x()) | voxelKey(v.y()) << 21 | voxelKey(v.z()) << 42, p.x(), p.y(),
+               p.z());
+    }
+  };
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < threads; ++t)
+    workers.emplace_back(work, t);
+  work(0);
+  for (auto& worker : workers)
+    worker.join();
+
+  for (std::size_t t = 1; t < threads; ++t)
+    grids[t].mergeInto(grids[0]);
+  out.resize(3, static_cast<Eigen::Index>(grids[0].size()));
+  Eigen::Index column = 0;
+  grids[0].forEach([&](const VoxelSum& sum) {
+    out.col(column++) = Eigen::Vector3f(sum.x, sum.y, sum.z) / static_cast<float>(sum.count);
+  });
+}
+
+void cloudPoints(const sensor_msgs::msg::PointCloud2& cloud, Eigen::Matrix3Xf& out)
+{
+  auto hasField = [&cloud](const std::string& name) {
+    return std::any_of(cloud.fields.begin(), cloud.fields.end(),
+                       [&name](const sensor_msgs::msg::PointField& f) { return f.name == name; });
+  };
+  if (!hasField("x") || !hasField("y") || !hasField("z"))
+  {
+    out.resize(3, 0);
+    return;
+  }
+  out.resize(3, static_cast<Eigen::Index>(cloud.width) * cloud.height);
+  Eigen::Index kept = 0;
+  sensor_msgs::PointCloud2ConstIterator<float> x(cloud, "x"), y(cloud, "y"), z(cloud, "z");
+  for (; x != x.end(); ++x, ++y, ++z)
+    if (std::isfinite(*x) && std::isfinite(*y) && std::isfinite(*z))
+      out.col(kept++) << *x, *y, *z;
+  out.conservativeResize(3, kept);
+}
+}  // namespace welding_demo
@@ -0,0 +1,170 @@
+// Stand-in sensor: replays point clouds from files into the shared memory cloud buffer that
+// welding_demo_node reads with cloud_buffer:=<name>. Clouds are ASCII .xyz files (one "x y z" per
+// line) or binary little-endian .ply files with float x, y, z vertex properties.
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <welding_demo/cloud_ring_buffer.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("cloud_replay");
+
+namespace
+{
+bool endsWith(const std::string& s, const std::string& suffix)
+{
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool loadXyz(const std::string& path, std::vector<float>& points)
+{
+  std::ifstream in(path);
+  if (!in)
+    return false;
+  std::string line;
+  while (std::getline(in, line))
+  {
+    std::istringstream fields(line);
+    float x, y, z;
+    if (fields >> x >> y >> z)
+      points.insert(points.end(), { x, y, z });
+  }
+  return true;
+}
+
+// Binary little-endian PLY, only the vertex element is read
+bool loadPly(const std::string& path, std::vector<float>& points)
+{
+  std::ifstream in(path, std::ios::binary);
+  std::string line;
+  if (!in || !std::getline(in, line) || line.rfind("ply", 0) != 0)
+    return false;
+  std::size_t vertices = 0;
+  std::vector<std::string> properties;
+  bool in_vertex = false;
+  bool binary = false;
+  while (std::getline(in, line) && line.rfind("end_header", 0) != 0)
+  {
+    std::istringstream fields(line);
+    std::string keyword;
+    fields >> keyword;
+    if (keyword == "format")
+    {
+      std::string format;
+      fields >> format;
+      binary = format == "binary_little_endian";
+    }
+    else if (keyword == "element")
+    {
+      std::string element;
+      fields >> element;
+      in_vertex = element == "vertex";
+      if (in_vertex)
+        fields >> vertices;
+    }
+    else if (keyword == "property" && in_vertex)
+    {
+      std::string type, name;
+      fields >> type >> name;
+      if (type != "float" && type != "float32")
+        return false;
+      properties.push_back(name);
+    }
+  }
+  const auto column = [&](const std::string& name) {
+    return std::find(properties.begin(), properties.end(), name) - properties.begin();
+  };
+  const auto x = column("x"), y = column("y"), z = column("z");
+  const auto stride = static_cast<std::ptrdiff_t>(properties.size());
+  if (!binary || x >= stride || y >= stride || z >= stride)
+    return false;
+  std::vector<float> data(vertices * properties.size());
+  if (!in.read(reinterpret_cast<char*>(data.data()),
+               static_cast<std::streamsize>(data.size() * sizeof(float))))
+    return false;
+  points.reserve(points.size() + 3 * vertices);
+  for (std::size_t i = 0; i < vertices; ++i)
+  {
+    const float* v = data.data() + i * properties.size();
+    points.insert(points.end(), { v[x], v[y], v[z] });
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::NodeOptions node_options;
+  node_options.automatically_declare_parameters_from_overrides(true);
+  auto node = rclcpp::Node::make_shared("cloud_replay", node_options);
+
+  const std::string buffer = node->get_parameter_or<std::string>("buffer", "welding_points");
+  const auto files = node->get_parameter_or<std::vector<std::string>>("files", {});
+  const double rate = node->get_parameter_or("rate", 10.0);
+  const bool loop = node->get_parameter_or("loop", true);
+  const int64_t slots = node->get_parameter_or<int64_t>("slots", 4);
+
+  // Load everything up front, so the replay measures the transport and not the disk
+  std::vector<std::vector<float>> clouds;
+  std::size_t max_points = 0;
+  for (const auto& file : files)
+  {
+    std::vector<float> points;
+    const bool loaded = endsWith(file, ".ply") ? loadPly(file, points) : loadXyz(file, points);
+    if (!loaded || points.empty())
+    {
+      RCLCPP_WARN(LOGGER, "Could not read a point cloud from '%s'", file.c_str());
+      continue;
+    }
+    RCLCPP_INFO(LOGGER, "Loaded %zu points from '%s'", points.size() / 3, file.c_str());
+    max_points = std::max(max_points, points.size() / 3);
+    clouds.push_back(std::move(points));
+  }
+  if (clouds.empty())
+  {
+    RCLCPP_ERROR(LOGGER, "No point clouds to replay, set the 'files' parameter");
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  welding_demo::CloudRingBuffer ring(buffer, static_cast<uint32_t>(std::max<int64_t>(slots, 2)),
+                                     static_cast<uint32_t>(max_points));
+  if (!ring.isOpen())
+  {
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  rclcpp::WallRate period(rate);
+  std::size_t index = 0;
+  while (rclcpp::ok())
+  {
+    const std::vector<float>& cloud = clouds[index];
+    const auto point_count = static_cast<uint32_t>(cloud.size() / 3);
+    // The scan is stamped when it is handed over, like a driver stamping its frames
+    const uint64_t stamp = welding_demo::CloudRingBuffer::nowNs();
+    float* slot = ring.beginWrite(point_count);
+    std::memcpy(slot, cloud.data(), cloud.size() * sizeof(float));
+    ring.commit(stamp);
+    RCLCPP_DEBUG(LOGGER, "Published cloud %zu (%u points)", index, point_count);
+
+    if (++index == clouds.size())
+    {
+      if (!loop)
+        break;
+      index = 0;
+    }
+    period.sleep();
+  }
+
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,223 @@
+#include <welding_demo/cloud_ring_buffer.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <rclcpp/logging.hpp>
+
+namespace welding_demo
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("welding_demo.cloud_ring_buffer");
+
+namespace
+{
+constexpr uint64_t RING_MAGIC = 0x3130474e49524357;  // "WCRING01"
+
+std::string shmName(const std::string& name)
+{
+  return name.empty() || name[0] == '/' ? name : "/" + name;
+}
+}  // namespace
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "the ring buffer needs lock-free 64 bit atomics to work across processes");
+
+struct CloudRingBuffer::Header
+{
+  uint64_t magic;
+  uint32_t slot_count;
+  uint32_t max_points;
+  uint64_t slot_size;  // bytes per slot, including its Slot header
+  std::atomic<uint64_t> written;  // number of committed clouds
+};
+
+// Sequence lock: 2k + 1 while cloud k is written into the slot, 2k + 2 once it is complete
+struct CloudRingBuffer::Slot
+{
+  std::atomic<uint64_t> sequence;
+  uint64_t stamp_ns;
+  uint32_t point_count;
+  uint32_t reserved;
+
+  float* data()
+  {
+    return reinterpret_cast<float*>(this + 1);
+  }
+};
+
+CloudRingBuffer::CloudRingBuffer(const std::string& name) : name_(shmName(name))
+{
+  const int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+  {
+    if (errno == ENOENT)
+      RCLCPP_DEBUG(LOGGER, "Cloud buffer '%s' does not exist yet", name_.c_str());
+    else
+      RCLCPP_ERROR(LOGGER, "Could not open cloud buffer '%s': %s", name_.c_str(),
+                   strerror(errno));
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(Header))
+  {
+    RCLCPP_DEBUG(LOGGER, "Cloud buffer '%s' is not initialized yet", name_.c_str());
+    close(fd);
+    return;
+  }
+  size_ = static_cast<std::size_t>(st.st_size);
+  device_ = static_cast<uint64_t>(st.st_dev);
+  inode_ = static_cast<uint64_t>(st.st_ino);
+  void* mapping = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not map cloud buffer '%s': %s", name_.c_str(), strerror(errno));
+    return;
+  }
+  header_ = static_cast<Header*>(mapping);
+  const uint64_t magic = header_->magic;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (magic != RING_MAGIC || sizeof(Header) + header_->slot_count * header_->slot_size > size_)
+  {
+    // The producer publishes the magic last, a zero magic is a buffer still being set up
+    if (magic == 0)
+      RCLCPP_DEBUG(LOGGER, "Cloud buffer '%s' is not initialized yet", name_.c_str());
+    else
+      RCLCPP_ERROR(LOGGER, "Cloud buffer '%s' has an unknown layout", name_.c_str());
+    munmap(mapping, size_);
+    header_ = nullptr;
+  }
+}
+
+CloudRingBuffer::CloudRingBuffer(const std::string& name, uint32_t slots, uint32_t max_points)
+  : name_(shmName(name)), owner_(true)
+{
+  // Replace a buffer left behind by an earlier producer, consumers reopen it
+  shm_unlink(name_.c_str());
+  const int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+  if (fd < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not create cloud buffer '%s': %s", name_.c_str(), strerror(errno));
+    return;
+  }
+  const uint64_t slot_size = (sizeof(Slot) + 3ull * sizeof(float) * max_points + 63) & ~63ull;
+  size_ = sizeof(Header) + slots * slot_size;
+  void* mapping = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(size_)) == 0)
+    mapping = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not map cloud buffer '%s': %s", name_.c_str(), strerror(errno));
+    shm_unlink(name_.c_str());
+    return;
+  }
+  header_ = new (mapping) Header();
+  header_->slot_count = slots;
+  header_->max_points = max_points;
+  header_->slot_size = slot_size;
+  header_->written.store(0, std::memory_order_relaxed);
+  for (uint32_t i = 0; i < slots; ++i)
+    new (slot(i)) Slot();
+  // Publish the layout last, a consumer checks the magic before anything else
+  std::atomic_thread_fence(std::memory_order_release);
+  header_->magic = RING_MAGIC;
+  RCLCPP_INFO(LOGGER, "Created cloud buffer '%s' with %u slots of %u points (%.1f MB)",
+              name_.c_str(), slots, max_points, size_ / 1e6);
+}
+
+CloudRingBuffer::~CloudRingBuffer()
+{
+  if (header_)
+    munmap(header_, size_);
+  if (owner_)
+    shm_unlink(name_.c_str());
+}
+
+uint32_t CloudRingBuffer::maxPoints() const
+{
+  return header_ ? header_->max_points : 0;
+}
+
+CloudRingBuffer::Slot* CloudRingBuffer::slot(uint64_t index) const
+{
+  unsigned char* base = reinterpret_cast<unsigned char*>(header_ + 1);
+  return reinterpret_cast<Slot*>(base + (index % header_->slot_count) * header_->slot_size);
+}
+
+float* CloudRingBuffer::beginWrite(uint32_t point_count)
+{
+  if (!header_ || !owner_ || point_count > header_->max_points)
+    return nullptr;
+  pending_ = header_->written.load(std::memory_order_relaxed);
+  Slot* s = slot(pending_);
+  s->sequence.store(2 * pending_ + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  s->point_count = point_count;
+  return s->data();
+}
+
+void CloudRingBuffer::commit(uint64_t stamp_ns)
+{
+  if (!header_ || !owner_)
+    return;
+  Slot* s = slot(pending_);
+  s->stamp_ns = stamp_ns;
+  s->sequence.store(2 * pending_ + 2, std::memory_order_release);
+  header_->written.store(pending_ + 1, std::memory_order_release);
+}
+
+bool CloudRingBuffer::latest(CloudView& view, uint64_t after_sequence) const
+{
+  if (!header_)
+    return false;
+  const uint64_t written = header_->written.load(std::memory_order_acquire);
+  if (written == 0 || written <= after_sequence)
+    return false;
+  Slot* s = slot(written - 1);
+  if (s->sequence.load(std::memory_order_acquire) != 2 * written)
+    return false;  // already being overwritten
+  view.data = s->data();
+  view.point_count = s->point_count;
+  view.stamp_ns = s->stamp_ns;
+  view.sequence = written;
+  return stillValid(view);
+}
+
+bool CloudRingBuffer::stillValid(const CloudView& view) const
+{
+  if (!header_ || view.sequence == 0)
+    return false;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot(view.sequence - 1)->sequence.load(std::memory_order_relaxed) == 2 * view.sequence;
+}
+
+bool CloudRingBuffer::replaced() const
+{
+  if (!header_ || owner_)
+    return false;
+  const int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+  if (fd < 0)
+    return true;
+  struct stat st;
+  const bool same = fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_dev) == device_ &&
+                    static_cast<uint64_t>(st.st_ino) == inode_;
+  close(fd);
+  return !same;
+}
+
+uint64_t CloudRingBuffer::nowNs()
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count());
+}
+}  // namespace welding_demo
@@ -0,0 +1,52 @@
+#include <welding_demo/compressing_plan_store.hpp>
+#include <welding_demo/trajectory_compression.hpp>
+
+#include <rclcpp/logging.hpp>
+
+namespace welding_demo
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("welding_demo.compressing_plan_store");
+
+CompressingPlanStore::CompressingPlanStore(PlanStorePtr store, double tolerance, double period)
+  : store_(std::move(store)), tolerance_(tolerance), period_(period)
+{
+}
+
+bool CompressingPlanStore::storeTrajectory(const std::string& kind, uint64_t key,
+                                           const moveit_msgs::msg::RobotTrajectory& trajectory)
+{
+  moveit_msgs::msg::RobotTrajectory compressed;
+  compressed.multi_dof_joint_trajectory = trajectory.multi_dof_joint_trajectory;
+  compressTrajectory(trajectory.joint_trajectory, compressed.joint_trajectory, tolerance_);
+  RCLCPP_DEBUG(LOGGER, "Compressed %s trajectory from %zu to %zu points", kind.c_str(),
+               trajectory.joint_trajectory.points.size(),
+               compressed.joint_trajectory.points.size());
+  return store_->storeTrajectory(kind, key, compressed);
+}
+
+bool CompressingPlanStore::loadTrajectory(const std::string& kind, uint64_t key,
+                                          moveit_msgs::msg::RobotTrajectory& trajectory)
+{
+  moveit_msgs::msg::RobotTrajectory compressed;
+  if (!store_->loadTrajectory(kind, key, compressed))
+    return false;
+  trajectory.multi_dof_joint_trajectory = std::move(compressed.multi_dof_joint_trajectory);
+  decompressTrajectory(compressed.joint_trajectory, trajectory.joint_trajectory, period_);
+  return true;
+}
+
+std::size_t
+CompressingPlanStore::loadTrajectories(const std::string& kind,
+                                       std::vector<moveit_msgs::msg::RobotTrajectory>& trajectories)
+{
+  std::vector<moveit_msgs::msg::RobotTrajectory> compressed;
+  const std::size_t count = store_->loadTrajectories(kind, compressed);
+  for (auto& c : compressed)
+  {
+    trajectories.emplace_back();
+    trajectories.back().multi_dof_joint_trajectory = std::move(c.multi_dof_joint_trajectory);
+    decompressTrajectory(c.joint_trajectory, trajectories.back().joint_trajectory, period_);
+  }
+  return count;
+}
+}  // namespace welding_demo
@@ -0,0 +1,97 @@
+// Replacement of the global allocation functions that counts every heap allocation (see
+// welding_demo::heapAllocations()). Linked into welding_demo_node with the
+// WELDING_DEMO_COUNT_ALLOCATIONS option only: as part of the executable it takes precedence over
+// the allocation functions of libstdc++ for every library of the process.
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include <welding_demo/allocation_counter.hpp>
+
+namespace
+{
+void* allocate(std::size_t size, std::size_t alignment)
+{
+  welding_demo::countHeapAllocation();
+  size = size == 0 ? 1 : size;
+  for (;;)
+  {
+    void* p = nullptr;
+    if (alignment <= alignof(std::max_align_t))
+      p = std::malloc(size);
+    else if (posix_memalign(&p, alignment, size) != 0)
+      p = nullptr;
+    if (p)
+      return p;
+    const std::new_handler handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+    handler();
+  }
+}
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+  return allocate(size, alignof(std::max_align_t));
+}
+void* operator new[](std::size_t size)
+{
+  return allocate(size, alignof(std::max_align_t));
+}
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  return allocate(size, static_cast<std::size_t>(alignment));
+}
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return allocate(size, static_cast<std::size_t>(alignment));
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  try
+  {
+    return allocate(size, alignof(std::max_align_t));
+  }
+  catch (const std::bad_alloc&)
+  {
+    return nullptr;
+  }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return operator new(size, std::nothrow);
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+void operator delete[](void* p) noexcept
+{
+  std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
@@ -0,0 +1,320 @@
+#include <welding_demo/file_plan_store.hpp>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include <rclcpp/logging.hpp>
+#include <rclcpp/serialization.hpp>
+#include <rmw/rmw.h>
+#include <rosidl_typesupport_cpp/message_type_support.hpp>
+
+namespace welding_demo
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("welding_demo.file_plan_store");
+
+namespace
+{
+constexpr uint32_t FILE_MAGIC = 0x57445053;  // "WDPS"
+constexpr uint32_t FILE_VERSION = 2;  // 2: payload checksums
+constexpr uint32_t RECORD_MAGIC = 0x57445054;  // "WDPT"
+constexpr std::size_t ALIGNMENT = 8;
+
+struct FileHeader
+{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t reserved;
+};
+
+struct RecordHeader
+{
+  uint32_t magic;
+  uint32_t checksum;  // crc32() of the payload
+  uint64_t kind;
+  uint64_t key;
+  uint64_t size;
+};
+
+std::size_t padded(std::size_t size)
+{
+  return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+// CRC-32 (IEEE 802.3) of a record payload
+uint32_t crc32(const void* data, std::size_t size)
+{
+  static const std::array<uint32_t, 256> table = [] {
+    std::array<uint32_t, 256> entries{};
+    for (uint32_t i = 0; i < entries.size(); ++i)
+    {
+      uint32_t c = i;
+      for (int bit = 0; bit < 8; ++bit)
+        c = (c & 1u) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      entries[i] = c;
+    }
+    return entries;
+  }();
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  uint32_t crc = 0xffffffffu;
+  for (std::size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ bytes[i]) & 0xffu] ^ (crc >> 8);
+  return ~crc;
+}
+
+uint64_t kindId(const std::string& kind)
+{
+  return PlanKey().add(kind).value();
+}
+
+const rosidl_message_type_support_t* trajectoryTypeSupport()
+{
+  return rosidl_typesupport_cpp::get_message_type_support_handle<
+      moveit_msgs::msg::RobotTrajectory>();
+}
+}  // namespace
+
+FilePlanStore::FilePlanStore(const std::string& path) : path_(path)
+{
+  fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not open plan store '%s': %s", path.c_str(), strerror(errno));
+    return;
+  }
+  // Records appended by two processes would interleave, the log has a single writer
+  if (flock(fd_, LOCK_EX | LOCK_NB) != 0)
+  {
+    RCLCPP_ERROR(LOGGER, "Plan store '%s' is in use by another process: %s", path.c_str(),
+                 strerror(errno));
+    closeFile();
+    return;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) == 0)
+    file_size_ = static_cast<std::size_t>(st.st_size);
+  if (file_size_ == 0)
+  {
+    const FileHeader header{ FILE_MAGIC, FILE_VERSION, 0u };
+    if (pwrite(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+    {
+      RCLCPP_ERROR(LOGGER, "Could not initialize plan store '%s': %s", path.c_str(),
+                   strerror(errno));
+      closeFile();
+      return;
+    }
+    file_size_ = sizeof(header);
+  }
+  remap();
+  // Anything other than a plan store of this version is left untouched
+  FileHeader header{};
+  if (mapped_size_ >= sizeof(header))
+    std::memcpy(&header, mapping_, sizeof(header));
+  if (header.magic != FILE_MAGIC || header.version != FILE_VERSION)
+  {
+    RCLCPP_ERROR(LOGGER, "'%s' is not a plan store of version %u, refusing to open it",
+                 path.c_str(), FILE_VERSION);
+    closeFile();
+    return;
+  }
+  if (!scan(sizeof(FileHeader)))
+  {
+    closeFile();
+    return;
+  }
+  RCLCPP_INFO(LOGGER, "Opened plan store '%s' with %zu records", path.c_str(), index_.size());
+}
+
+FilePlanStore::~FilePlanStore()
+{
+  closeFile();
+}
+
+void FilePlanStore::closeFile()
+{
+  if (mapping_)
+    munmap(const_cast<unsigned char*>(mapping_), mapped_size_);
+  mapping_ = nullptr;
+  mapped_size_ = 0;
+  if (fd_ >= 0)
+    close(fd_);
+  fd_ = -1;
+  index_.clear();
+}
+
+bool FilePlanStore::remap()
+{
+  if (mapping_)
+    munmap(const_cast<unsigned char*>(mapping_), mapped_size_);
+  mapping_ = nullptr;
+  mapped_size_ = 0;
+  if (file_size_ == 0)
+    return true;
+  void* mapping = mmap(nullptr, file_size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (mapping == MAP_FAILED)
+    return false;
+  mapping_ = static_cast<const unsigned char*>(mapping);
+  mapped_size_ = file_size_;
+  return true;
+}
+
+bool FilePlanStore::scan(std::size_t from)
+{
+  std::size_t offset = from;
+  bool torn = false;
+  while (offset < mapped_size_)
+  {
+    // A record cut short by a crash during append: a partial header, a payload running past the
+    // end of the file, or the zero-filled blocks some file systems leave behind
+    if (offset + sizeof(RecordHeader) > mapped_size_)
+    {
+      torn = true;
+      break;
+    }
+    RecordHeader header;
+    std::memcpy(&header, mapping_ + offset, sizeof(header));
+    const std::size_t payload = offset + sizeof(RecordHeader);
+    if (header.magic != RECORD_MAGIC)
+    {
+      torn = std::all_of(mapping_ + offset, mapping_ + mapped_size_,
+                         [](unsigned char byte) { return byte == 0; });
+      break;
+    }
+    if (header.size > mapped_size_ - payload)
+    {
+      torn = true;
+      break;
+    }
+    // A payload that does not match its checksum was torn if it is the last record, bit rot
+    // otherwise
+    if (crc32(mapping_ + payload, header.size) != header.checksum)
+    {
+      torn = payload + padded(header.size) >= mapped_size_;
+      break;
+    }
+    index_[IndexKey{ header.kind, header.key }] = Entry{ payload, header.size };
+    offset = payload + padded(header.size);
+  }
+  if (offset >= file_size_)
+    return true;
+  if (!torn)
+  {
+    // Records appended behind a corrupted one could never be read back
+    RCLCPP_ERROR(LOGGER, "Corrupted record at offset %zu of '%s', refusing to open it", offset,
+                 path_.c_str());
+    return false;
+  }
+  RCLCPP_WARN(LOGGER, "Dropping %zu bytes of an incomplete record from '%s'", file_size_ - offset,
+              path_.c_str());
+  if (ftruncate(fd_, static_cast<off_t>(offset)) == 0)
+  {
+    file_size_ = offset;
+    remap();
+  }
+  return true;
+}
+
+bool FilePlanStore::append(uint64_t kind, uint64_t key, const void* payload, std::size_t size)
+{
+  if (fd_ < 0)
+    return false;
+  std::vector<unsigned char> record(sizeof(RecordHeader) + padded(size), 0);
+  const RecordHeader header{ RECORD_MAGIC, crc32(payload, size), kind, key, size };
+  std::memcpy(record.data(), &header, sizeof(header));
+  std::memcpy(record.data() + sizeof(header), payload, size);
+
+  if (pwrite(fd_, record.data(), record.size(), static_cast<off_t>(file_size_)) !=
+      static_cast<ssize_t>(record.size()))
+  {
+    RCLCPP_ERROR(LOGGER, "Could not append to plan store '%s': %s", path_.c_str(),
+                 strerror(errno));
+    return false;
+  }
+  index_[IndexKey{ kind, key }] = Entry{ file_size_ + sizeof(RecordHeader), size };
+  file_size_ += record.size();
+  return true;
+}
+
+const FilePlanStore::Entry* FilePlanStore::find(uint64_t kind, uint64_t key)
+{
+  const auto it = index_.find(IndexKey{ kind, key });
+  if (it == index_.end())
+    return nullptr;
+  if (it->second.offset + it->second.size > mapped_size_ && !remap())
+    return nullptr;
+  return &it->second;
+}
+
+bool FilePlanStore::storeTrajectory(const std::string& kind, uint64_t key,
+                                    const moveit_msgs::msg::RobotTrajectory& trajectory)
+{
+  rclcpp::Serialization<moveit_msgs::msg::RobotTrajectory> serialization;
+  rclcpp::SerializedMessage serialized;
+  serialization.serialize_message(&trajectory, &serialized);
+  const auto& raw = serialized.get_rcl_serialized_message();
+  return append(kindId(kind), key, raw.buffer, raw.buffer_length);
+}
+
+bool FilePlanStore::loadTrajectory(const std::string& kind, uint64_t key,
+                                   moveit_msgs::msg::RobotTrajectory& trajectory)
+{
+  const Entry* entry = find(kindId(kind), key);
+  if (!entry)
+    return false;
+  // Wrap the mapped bytes without copying them; deserialization only reads the buffer
+  rmw_serialized_message_t raw = rmw_get_zero_initialized_serialized_message();
+  raw.buffer = const_cast<uint8_t*>(mapping_ + entry->offset);
+  raw.buffer_length = entry->size;
+  raw.buffer_capacity = entry->size;
+  return rmw_deserialize(&raw, trajectoryTypeSupport(), &trajectory) == RMW_RET_OK;
+}
+
+std::size_t
+FilePlanStore::loadTrajectories(const std::string& kind,
+                                std::vector<moveit_msgs::msg::RobotTrajectory>& trajectories)
+{
+  const uint64_t id = kindId(kind);
+  if (file_size_ > mapped_size_ && !remap())
+    return 0;
+  std::size_t count = 0;
+  for (const auto& item : index_)
+  {
+    if (item.first.kind != id)
+      continue;
+    rmw_serialized_message_t raw = rmw_get_zero_initialized_serialized_message();
+    raw.buffer = const_cast<uint8_t*>(mapping_ + item.second.offset);
+    raw.buffer_length = item.second.size;
+    raw.buffer_capacity = item.second.size;
+    trajectories.emplace_back();
+    if (rmw_deserialize(&raw, trajectoryTypeSupport(), &trajectories.back()) != RMW_RET_OK)
+    {
+      trajectories.pop_back();
+      continue;
+    }
+    ++count;
+  }
+  return count;
+}
+
+bool FilePlanStore::storeSeed(uint64_t key, const std::vector<double>& positions)
+{
+  return append(kindId("seed"), key, positions.data(), positions.size() * sizeof(double));
+}
+
+bool FilePlanStore::loadSeed(uint64_t key, std::vector<double>& positions)
+{
+  const Entry* entry = find(kindId("seed"), key);
+  if (!entry)
+    return false;
+  positions.resize(entry->size / sizeof(double));
+  std::memcpy(positions.data(), mapping_ + entry->offset, entry->size);
+  return true;
+}
+}  // namespace welding_demo
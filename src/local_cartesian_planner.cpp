@@ -0,0 +1,86 @@
+#include <welding_demo/local_cartesian_planner.hpp>
+
+#include <moveit/robot_state/cartesian_interpolator.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <tf2_eigen/tf2_eigen.hpp>
+
+namespace welding_demo
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("welding_demo.local_cartesian_planner");
+
+LocalCartesianPlanner::LocalCartesianPlanner(
+    const rclcpp::Node::SharedPtr& node,
+    const robot_model_loader::RobotModelLoaderPtr& robot_model_loader, const std::string& group,
+    const std::string& tip_link)
+{
+  monitor_ = std::make_shared<planning_scene_monitor::PlanningSceneMonitor>(
+      node, robot_model_loader, "welding_demo_scene");
+  const moveit::core::RobotModelConstPtr& model = monitor_->getRobotModel();
+  if (!model)
+  {
+    RCLCPP_ERROR(LOGGER, "No robot model, in-process planning is not available");
+    return;
+  }
+  group_ = model->getJointModelGroup(group);
+  tip_ = model->getLinkModel(tip_link);
+  if (!ready())
+  {
+    RCLCPP_ERROR(LOGGER, "Unknown planning group '%s' or tip link '%s'", group.c_str(),
+                 tip_link.c_str());
+    return;
+  }
+  // Follow move_group's scene: fetch it once, then apply its diffs
+  monitor_->requestPlanningSceneState();
+  monitor_->startSceneMonitor();
+  monitor_->startStateMonitor();
+}
+
+double LocalCartesianPlanner::plan(const std::vector<double>& start,
+                                   const std::vector<geometry_msgs::msg::Pose>& waypoints,
+                                   double eef_step, double jump_threshold,
+                                   moveit_msgs::msg::RobotTrajectory& trajectory,
+                                   bool avoid_collisions)
+{
+  if (!ready() || waypoints.empty())
+    return 0.0;
+  planning_scene_monitor::LockedPlanningSceneRO scene(monitor_);
+  moveit::core::RobotState start_state = scene->getCurrentState();
+  if (!start.empty())
+    start_state.setJointGroupPositions(group_, start);
+  start_state.update();
+
+  EigenSTL::vector_Isometry3d poses(waypoints.size());
+  for (std::size_t i = 0; i < waypoints.size(); ++i)
+    tf2::fromMsg(waypoints[i], poses[i]);
+
+  moveit::core::GroupStateValidityCallbackFn valid;
+  if (avoid_collisions)
+  {
+    const planning_scene::PlanningSceneConstPtr& planning_scene = scene;
+    valid = [planning_scene](moveit::core::RobotState* state,
+                             const moveit::core::JointModelGroup* group, const double* values) {
+      state->setJointGroupPositions(group, values);
+      state->update();
+      return !planning_scene->isStateColliding(*state, group->getName());
+    };
+  }
+
+  std::vector<moveit::core::RobotStatePtr> states;
+  const double fraction = moveit::core::CartesianInterpolator::computeCartesianPath(
+      &start_state, group_, states, tip_, poses, true, moveit::core::MaxEEFStep(eef_step),
+      moveit::core::JumpThreshold(jump_threshold), valid);
+
+  robot_trajectory::RobotTrajectory result(start_state.getRobotModel(), group_);
+  for (const auto& state : states)
+    result.addSuffixWayPoint(state, 0.0);
+  trajectory_processing::TimeOptimalTrajectoryGeneration time_parameterization;
+  if (!time_parameterization.computeTimeStamps(result))
+  {
+    RCLCPP_WARN(LOGGER, "Time parameterization of the Cartesian path failed");
+    return 0.0;
+  }
+  result.getRobotTrajectoryMsg(trajectory);
+  return fraction;
+}
+}  // namespace welding_demo
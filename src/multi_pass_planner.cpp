@@ -0,0 +1,142 @@
+#include <welding_demo/multi_pass_planner.hpp>
+#include <welding_demo/seam.hpp>
+#include <welding_demo/trajectory_compression.hpp>
+#include <welding_demo/trajectory_time.hpp>
+
+#include <cmath>
+
+#include <tf2_eigen/tf2_eigen.hpp>
+
+namespace welding_demo
+{
+namespace
+{
+// Minimum sine of the angle between travel direction and seam normal for a pose to define its own
+// lateral direction
+constexpr double MIN_LATERAL_SINE = 0.5;
+}  // namespace
+
+std::vector<Eigen::Isometry3d> offsetPath(const std::vector<Eigen::Isometry3d>& path,
+                                          const PassOffset& offset)
+{
+  const std::size_t n = path.size();
+  std::vector<Eigen::Isometry3d> result = path;
+  if (n < 2)
+    return result;
+
+  // Lateral direction of every pose; poses without one inherit it from a neighbour
+  std::vector<Eigen::Vector3d> lateral(n, Eigen::Vector3d::Zero());
+  std::vector<bool> valid(n, false);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const std::size_t prev = i > 0 ? i - 1 : i;
+    const std::size_t next = i + 1 < n ? i + 1 : i;
+    const Eigen::Vector3d travel = path[next].translation() - path[prev].translation();
+    if (travel.norm() <= 0.0)
+      continue;
+    const Eigen::Vector3d cross = seamNormal(path[i]).cross(travel.normalized());
+    if (cross.norm() < MIN_LATERAL_SINE)
+      continue;
+    lateral[i] = cross.normalized();
+    valid[i] = true;
+  }
+  for (std::size_t i = 1; i < n; ++i)
+    if (!valid[i] && valid[i - 1])
+    {
+      lateral[i] = lateral[i - 1];
+      valid[i] = true;
+    }
+  for (std::size_t i = n - 1; i-- > 0;)
+    if (!valid[i] && valid[i + 1])
+    {
+      lateral[i] = lateral[i + 1];
+      valid[i] = true;
+    }
+
+  for (std::size_t i = 0; i < n; ++i)
+    result[i].translation() +=
+        offset.lateral * lateral[i] + offset.lift * seamNormal(path[i]);
+  return result;
+}
+
+std::vector<geometry_msgs::msg::Pose> offsetWaypoints(
+    const std::vector<geometry_msgs::msg::Pose>& waypoints, const PassOffset& offset)
+{
+  std::vector<Eigen::Isometry3d> path(waypoints.size());
+  for (std::size_t i = 0; i < waypoints.size(); ++i)
+    tf2::fromMsg(waypoints[i], path[i]);
+  path = offsetPath(path, offset);
+  std::vector<geometry_msgs::msg::Pose> result(path.size());
+  for (std::size_t i = 0; i < path.size(); ++i)
+    result[i] = tf2::toMsg(path[i]);
+  return result;
+}
+
+bool derivePass(const moveit_msgs::msg::RobotTrajectory& root, moveit::core::RobotState& state,
+                const moveit::core::JointModelGroup* group, const moveit::core::LinkModel* tip,
+                const PassOffset& offset, moveit_msgs::msg::RobotTrajectory& pass,
+                double ik_timeout, double max_joint_step)
+{
+  const auto& jt = root.joint_trajectory;
+  const std::size_t n = jt.points.size();
+  if (n == 0)
+    return false;
+
+  // Tool path of the root pass
+  std::vector<Eigen::Isometry3d> path(n);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    state.setVariablePositions(jt.joint_names, jt.points[i].positions);
+    state.updateLinkTransforms();
+    path[i] = state.getGlobalLinkTransform(tip);
+  }
+  path = offsetPath(path, offset);
+
+  const auto dof = static_cast<Eigen::Index>(jt.joint_names.size());
+  Eigen::MatrixXd positions(static_cast<Eigen::Index>(n), dof);
+  Eigen::VectorXd times(static_cast<Eigen::Index>(n));
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const auto row = static_cast<Eigen::Index>(i);
+    state.setVariablePositions(jt.joint_names, jt.points[i].positions);
+    if (!state.setFromIK(group, path[i], tip->getName(), ik_timeout))
+      return false;
+    for (Eigen::Index j = 0; j < dof; ++j)
+      positions(row, j) = state.getVariablePosition(jt.joint_names[static_cast<std::size_t>(j)]);
+    if (i > 0)
+    {
+      // The pass has to move like the root pass, anything else is a branch flip
+      const Eigen::RowVectorXd root_step =
+          Eigen::Map<const Eigen::RowVectorXd>(jt.points[i].positions.data(), dof) -
+          Eigen::Map<const Eigen::RowVectorXd>(jt.points[i - 1].positions.data(), dof);
+      const Eigen::RowVectorXd pass_step = positions.row(row) - positions.row(row - 1);
+      if ((pass_step - root_step).cwiseAbs().maxCoeff() > max_joint_step)
+        return false;
+    }
+    times[row] = toSec(jt.points[i].time_from_start);
+  }
+
+  const Eigen::MatrixXd velocities = estimateVelocities(times, positions);
+  const Eigen::MatrixXd accelerations = estimateVelocities(times, velocities);
+  // Only the header and joint names are taken over from the root pass, the points are new
+  auto& pass_jt = pass.joint_trajectory;
+  pass_jt.header = jt.header;
+  pass_jt.joint_names = jt.joint_names;
+  pass_jt.points.resize(n);
+  pass.multi_dof_joint_trajectory = trajectory_msgs::msg::MultiDOFJointTrajectory();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const auto row = static_cast<Eigen::Index>(i);
+    auto& point = pass_jt.points[i];
+    point.time_from_start = jt.points[i].time_from_start;
+    point.effort.clear();
+    const Eigen::RowVectorXd q = positions.row(row);
+    const Eigen::RowVectorXd v = velocities.row(row);
+    const Eigen::RowVectorXd a = accelerations.row(row);
+    point.positions.assign(q.data(), q.data() + dof);
+    point.velocities.assign(v.data(), v.data() + dof);
+    point.accelerations.assign(a.data(), a.data() + dof);
+  }
+  return true;
+}
+}  // namespace welding_demo
@@ -0,0 +1,65 @@
+#include <welding_demo/plan_store.hpp>
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+namespace welding_demo
+{
+void PlanKey::mix(const void* data, std::size_t size)
+{
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    hash_ ^= bytes[i];
+    hash_ *= 1099511628211ull;
+  }
+}
+
+PlanKey& PlanKey::add(const std::string& value)
+{
+  mix(value.data(), value.size());
+  const char separator = '\0';
+  mix(&separator, 1);
+  return *this;
+}
+
+PlanKey& PlanKey::add(double value, double quantum)
+{
+  const auto q = static_cast<int64_t>(std::llround(value / quantum));
+  mix(&q, sizeof(q));
+  return *this;
+}
+
+PlanKey& PlanKey::add(const std::vector<double>& values, double quantum)
+{
+  for (double v : values)
+    add(v, quantum);
+  return *this;
+}
+
+PlanKey& PlanKey::add(const std::vector<geometry_msgs::msg::Pose>& poses, double position_quantum,
+                      double orientation_quantum)
+{
+  for (const auto& pose : poses)
+  {
+    add(pose.position.x, position_quantum);
+    add(pose.position.y, position_quantum);
+    add(pose.position.z, position_quantum);
+    // q and -q are the same rotation, hash the one with a non-negative w
+    const double sign = pose.orientation.w < 0.0 ? -1.0 : 1.0;
+    add(sign * pose.orientation.x, orientation_quantum);
+    add(sign * pose.orientation.y, orientation_quantum);
+    add(sign * pose.orientation.z, orientation_quantum);
+    add(sign * pose.orientation.w, orientation_quantum);
+  }
+  return *this;
+}
+
+std::string PlanKey::str() const
+{
+  char buffer[17];
+  std::snprintf(buffer, sizeof(buffer), "%016" PRIx64, hash_);
+  return buffer;
+}
+}  // namespace welding_demo
@@ -0,0 +1,167 @@
+// Benchmark of cold against warm start planning. Transits between random configurations of the
+// planning group are planned with move_group (cold) and stored in a plan store. A fresh roadmap is
+// then warm-started from the store the way welding_demo_node does it, and the same requests are
+// planned again (warm). Run it next to the demo's move_group, with the same robot_description
+// parameters, e.g. plan_store:=warehouse with the demo launch file's database.
+
+#include <rclcpp/rclcpp.hpp>
+#include <moveit/move_group_interface/move_group_interface.h>
+#include <moveit/robot_state/robot_state.h>
+#include <random_numbers/random_numbers.h>
+
+#include <welding_demo/file_plan_store.hpp>
+#include <welding_demo/plan_store.hpp>
+#include <welding_demo/transit_planner.hpp>
+#include <welding_demo/warehouse_plan_store.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <thread>
+
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("plan_store_benchmark");
+
+namespace
+{
+struct Timings
+{
+  std::vector<double> ms;
+  std::size_t failed = 0;
+
+  void report(const char* label)
+  {
+    if (ms.empty())
+    {
+      RCLCPP_INFO(LOGGER, "%s: no successful plans, %zu failed", label, failed);
+      return;
+    }
+    std::sort(ms.begin(), ms.end());
+    double total = 0.0;
+    for (double t : ms)
+      total += t;
+    RCLCPP_INFO(LOGGER, "%s: %zu plans, mean %.3f ms, median %.3f ms, max %.3f ms, %zu failed",
+                label, ms.size(), total / static_cast<double>(ms.size()), ms[ms.size() / 2],
+                ms.back(), failed);
+  }
+};
+
+// Plans every transit of the cycle through the configurations once
+Timings planTransits(welding_demo::TransitPlanner& planner,
+                     const std::vector<std::vector<double>>& configurations,
+                     welding_demo::PlanStore* store)
+{
+  Timings timings;
+  for (std::size_t i = 0; i < configurations.size(); ++i)
+  {
+    const std::vector<double>& start = configurations[i];
+    const std::vector<double>& goal = configurations[(i + 1) % configurations.size()];
+    moveit_msgs::msg::RobotTrajectory transit;
+    bool cache_hit = false;
+    const auto begin = std::chrono::steady_clock::now();
+    const bool success = planner.plan(start, goal, transit, &cache_hit);
+    const double ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin)
+            .count();
+    if (!success)
+    {
+      ++timings.failed;
+      continue;
+    }
+    timings.ms.push_back(ms);
+    if (store && !cache_hit)
+      store->storeTrajectory(
+          "transit", welding_demo::PlanKey().add(start, 1e-3).add(goal, 1e-3).value(), transit);
+  }
+  return timings;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::NodeOptions node_options;
+  node_options.automatically_declare_parameters_from_overrides(true);
+  auto node = rclcpp::Node::make_shared("plan_store_benchmark", node_options);
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(node);
+  std::thread spinner([&executor]() { executor.spin(); });
+
+  const std::string group =
+      node->get_parameter_or<std::string>("planning_group", "ur_manipulator");
+  const std::string store_type = node->get_parameter_or<std::string>("plan_store", "file");
+  const std::string store_file = node->get_parameter_or<std::string>(
+      "plan_store_file", "/tmp/welding_demo_benchmark.plans");
+  const int64_t configurations =
+      std::max<int64_t>(2, node->get_parameter_or<int64_t>("configurations", 10));
+  const double joint_tolerance = node->get_parameter_or("transit_joint_tolerance", 0.01);
+
+  int status = 0;
+  {
+    moveit::planning_interface::MoveGroupInterface move_group(node, group);
+    const moveit::core::JointModelGroup* jmg =
+        move_group.getRobotModel()->getJointModelGroup(group);
+
+    welding_demo::PlanStorePtr store;
+    if (store_type == "warehouse")
+    {
+      auto warehouse = std::make_shared<welding_demo::WarehousePlanStore>(node);
+      if (warehouse->connected())
+        store = warehouse;
+    }
+    else
+    {
+      auto file = std::make_shared<welding_demo::FilePlanStore>(store_file);
+      if (file->isOpen())
+        store = file;
+    }
+
+    if (!jmg || !store)
+    {
+      RCLCPP_ERROR(LOGGER, "Unknown planning group '%s' or plan store '%s' not available",
+                   group.c_str(), store_type.c_str());
+      status = 1;
+    }
+    else
+    {
+      // Random configurations, the same ones on every run
+      std::vector<std::vector<double>> samples(static_cast<std::size_t>(configurations));
+      moveit::core::RobotState state(move_group.getRobotModel());
+      state.setToDefaultValues();
+      random_numbers::RandomNumberGenerator rng(1);
+      for (auto& sample : samples)
+      {
+        state.setToRandomPositions(jmg, rng);
+        state.copyJointGroupPositions(jmg, sample);
+      }
+      RCLCPP_INFO(LOGGER, "Planning %" PRId64 " transits of '%s'", configurations, group.c_str());
+
+      welding_demo::TransitPlanner cold_planner(move_group, joint_tolerance);
+      Timings cold = planTransits(cold_planner, samples, store.get());
+
+      // Warm start of a new process: only the plan store survives
+      welding_demo::TransitPlanner warm_planner(move_group, joint_tolerance);
+      const auto load_begin = std::chrono::steady_clock::now();
+      std::vector<moveit_msgs::msg::RobotTrajectory> transits;
+      store->loadTrajectories("transit", transits);
+      std::size_t inserted = 0;
+      for (const auto& transit : transits)
+        inserted += warm_planner.roadmap().insert(transit, jmg->getVariableNames());
+      const double load_ms = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - load_begin)
+                                 .count();
+      Timings warm = planTransits(warm_planner, samples, nullptr);
+
+      cold.report("Cold start");
+      RCLCPP_INFO(LOGGER, "Warm start loaded %zu of %zu stored plans in %.3f ms", inserted,
+                  transits.size(), load_ms);
+      warm.report("Warm start");
+      RCLCPP_INFO(LOGGER, "Warm start roadmap hits: %zu, misses: %zu", warm_planner.hits(),
+                  warm_planner.misses());
+    }
+  }
+
+  executor.cancel();
+  spinner.join();
+  rclcpp::shutdown();
+  return status;
+}
@@ -0,0 +1,85 @@
+#include <welding_demo/pose_batch.hpp>
+
+#include <cmath>
+
+namespace welding_demo
+{
+// The kernels write every output row from all input rows, so ``out`` must not be an input. Row
+// expressions are kept as unevaluated Eigen expressions and fused into one loop per output row.
+
+void PoseBatch::toMsgs(std::vector<geometry_msgs::msg::Pose>& poses) const
+{
+  poses.resize(static_cast<std::size_t>(size()));
+  for (Eigen::Index i = 0; i < size(); ++i)
+  {
+    auto& pose = poses[static_cast<std::size_t>(i)];
+    pose.position.x = positions(0, i);
+    pose.position.y = positions(1, i);
+    pose.position.z = positions(2, i);
+    pose.orientation.w = orientations(0, i);
+    pose.orientation.x = orientations(1, i);
+    pose.orientation.y = orientations(2, i);
+    pose.orientation.z = orientations(3, i);
+  }
+}
+
+void PoseBatch::fromMsgs(const std::vector<geometry_msgs::msg::Pose>& poses)
+{
+  resize(static_cast<Eigen::Index>(poses.size()));
+  for (Eigen::Index i = 0; i < size(); ++i)
+  {
+    const auto& pose = poses[static_cast<std::size_t>(i)];
+    positions.col(i) << pose.position.x, pose.position.y, pose.position.z;
+    orientations.col(i) << pose.orientation.w, pose.orientation.x, pose.orientation.y,
+        pose.orientation.z;
+  }
+}
+
+void compose(const QuaternionBatch& a, const QuaternionBatch& b, QuaternionBatch& out)
+{
+  const auto aw = a.row(0).array(), ax = a.row(1).array(), ay = a.row(2).array(),
+             az = a.row(3).array();
+  const auto bw = b.row(0).array(), bx = b.row(1).array(), by = b.row(2).array(),
+             bz = b.row(3).array();
+  out.resize(4, a.cols());
+  out.row(0).array() = aw * bw - ax * bx - ay * by - az * bz;
+  out.row(1).array() = aw * bx + ax * bw + ay * bz - az * by;
+  out.row(2).array() = aw * by - ax * bz + ay * bw + az * bx;
+  out.row(3).array() = aw * bz + ax * by - ay * bx + az * bw;
+}
+
+void fromTwoVectors(const Vector3Batch& from, const Vector3Batch& to, QuaternionBatch& out)
+{
+  const auto fx = from.row(0).array(), fy = from.row(1).array(), fz = from.row(2).array();
+  const auto tx = to.row(0).array(), ty = to.row(1).array(), tz = to.row(2).array();
+  const Eigen::Array<double, 1, Eigen::Dynamic> lengths =
+      ((fx.square() + fy.square() + fz.square()) * (tx.square() + ty.square() + tz.square()))
+          .sqrt();
+  // The unnormalized half-way quaternion (|f||t| + f.t, f x t). It vanishes for opposite
+  // vectors, which turn about f x X instead, or f x Y when f is close to X.
+  out.resize(4, from.cols());
+  out.row(0).array() = lengths + fx * tx + fy * ty + fz * tz;
+  const Eigen::Array<bool, 1, Eigen::Dynamic> opposite = out.row(0).array() <= 1e-12 * lengths;
+  const auto along_x = fx.abs() > 0.9 * (fx.square() + fy.square() + fz.square()).sqrt();
+  out.row(0).array() = opposite.select(0.0, out.row(0).array());
+  out.row(1).array() = opposite.select(along_x.select(-fz, 0.0), fy * tz - fz * ty);
+  out.row(2).array() = opposite.select(along_x.select(0.0, fz), fz * tx - fx * tz);
+  out.row(3).array() = opposite.select(along_x.select(fx, -fy), fx * ty - fy * tx);
+
+  const Eigen::Array<double, 1, Eigen::Dynamic> norms =
+      (out.row(0).array().square() + out.row(1).array().square() + out.row(2).array().square() +
+       out.row(3).array().square())
+          .sqrt();
+  // Zero vectors give the identity
+  out.row(0).array() = (norms > 0.0).select(out.row(0).array() / norms, 1.0);
+  for (Eigen::Index k = 1; k < 4; ++k)
+    out.row(k).array() = (norms > 0.0).select(out.row(k).array() / norms, 0.0);
+}
+
+void seamOrientations(const Vector3Batch& normals, QuaternionBatch& out)
+{
+  Vector3Batch tool_x = Vector3Batch::Zero(3, normals.cols());
+  tool_x.row(0).setOnes();
+  fromTwoVectors(normals, tool_x, out);
+}
+}  // namespace welding_demo
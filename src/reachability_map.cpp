@@ -0,0 +1,232 @@
+#include <welding_demo/reachability_map.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace welding_demo
+{
+namespace
+{
+constexpr char MAGIC[8] = { 'W', 'D', 'R', 'M', 'A', 'P', '0', '1' };
+
+// On-disk header, followed directly by the cell array
+struct FileHeader
+{
+  char magic[8];
+  uint32_t size[3];
+  uint32_t reserved;
+  double origin[3];
+  double resolution;
+};
+}  // namespace
+
+ReachabilityMap::~ReachabilityMap()
+{
+  unmap();
+}
+
+ReachabilityMap::ReachabilityMap(ReachabilityMap&& other) noexcept
+{
+  *this = std::move(other);
+}
+
+ReachabilityMap& ReachabilityMap::operator=(ReachabilityMap&& other) noexcept
+{
+  if (this == &other)
+    return *this;
+  unmap();
+  origin_ = other.origin_;
+  resolution_ = other.resolution_;
+  std::copy(other.size_, other.size_ + 3, size_);
+  const bool owns_storage = other.mapping_ == nullptr;
+  storage_ = std::move(other.storage_);
+  cells_ = owns_storage ? storage_.data() : other.cells_;
+  mapping_ = other.mapping_;
+  mapping_size_ = other.mapping_size_;
+  other.cells_ = nullptr;
+  other.mapping_ = nullptr;
+  other.mapping_size_ = 0;
+  return *this;
+}
+
+void ReachabilityMap::unmap()
+{
+  if (mapping_)
+    munmap(mapping_, mapping_size_);
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  cells_ = storage_.empty() ? nullptr : storage_.data();
+}
+
+void ReachabilityMap::allocate(const Eigen::AlignedBox3d& bounds, double resolution)
+{
+  unmap();
+  origin_ = bounds.min();
+  resolution_ = resolution;
+  const Eigen::Vector3d extent = bounds.sizes() / resolution;
+  for (int i = 0; i < 3; ++i)
+    size_[i] = static_cast<uint32_t>(std::max(1.0, std::ceil(extent[i])));
+  storage_.assign(static_cast<std::size_t>(size_[0]) * size_[1] * size_[2], Cell{ 0u, 0.0f });
+  cells_ = storage_.data();
+}
+
+int ReachabilityMap::directionBin(const Eigen::Vector3d& direction)
+{
+  // Cube-map style binning: pick the dominant axis and its sign, then split the face into four
+  // quadrants by the signs of the remaining two components.
+  Eigen::Vector3d::Index axis;
+  direction.cwiseAbs().maxCoeff(&axis);
+  const int face = static_cast<int>(axis) * 2 + (direction[axis] < 0.0 ? 1 : 0);
+  const double u = direction[(axis + 1) % 3];
+  const double v = direction[(axis + 2) % 3];
+  return face * 4 + (u < 0.0 ? 1 : 0) + (v < 0.0 ? 2 : 0);
+}
+
+bool ReachabilityMap::index(const Eigen::Vector3d& point, std::size_t& idx) const
+{
+  if (!cells_)
+    return false;
+  const Eigen::Vector3d rel = (point - origin_) / resolution_;
+  if ((rel.array() < 0.0).any())
+    return false;
+  const auto x = static_cast<uint32_t>(rel.x());
+  const auto y = static_cast<uint32_t>(rel.y());
+  const auto z = static_cast<uint32_t>(rel.z());
+  if (x >= size_[0] || y >= size_[1] || z >= size_[2])
+    return false;
+  idx = (static_cast<std::size_t>(z) * size_[1] + y) * size_[0] + x;
+  return true;
+}
+
+void ReachabilityMap::addSample(const Eigen::Isometry3d& tool_pose, double manipulability)
+{
+  std::size_t idx;
+  if (mapping_ || !index(tool_pose.translation(), idx))
+    return;
+  Cell& c = cells_[idx];
+  c.direction_mask |= 1u << directionBin(tool_pose.linear().col(2));
+  c.manipulability = std::max(c.manipulability, static_cast<float>(manipulability));
+}
+
+bool ReachabilityMap::merge(const ReachabilityMap& other)
+{
+  if (mapping_ || other.resolution_ != resolution_ || !other.origin_.isApprox(origin_) ||
+      !std::equal(size_, size_ + 3, other.size_))
+    return false;
+  const std::size_t n = storage_.size();
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    cells_[i].direction_mask |= other.cells_[i].direction_mask;
+    cells_[i].manipulability = std::max(cells_[i].manipulability, other.cells_[i].manipulability);
+  }
+  return true;
+}
+
+bool ReachabilityMap::save(const std::string& path) const
+{
+  if (!cells_)
+    return false;
+  FileHeader header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  std::copy(size_, size_ + 3, header.size);
+  for (int i = 0; i < 3; ++i)
+    header.origin[i] = origin_[i];
+  header.resolution = resolution_;
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out)
+    return false;
+  const std::size_t n = static_cast<std::size_t>(size_[0]) * size_[1] * size_[2];
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(cells_), static_cast<std::streamsize>(n * sizeof(Cell)));
+  return static_cast<bool>(out);
+}
+
+bool ReachabilityMap::load(const std::string& path)
+{
+  storage_.clear();
+  unmap();
+
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(FileHeader))
+  {
+    close(fd);
+    return false;
+  }
+  void* mapping =
+      mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+    return false;
+
+  const auto* header = static_cast<const FileHeader*>(mapping);
+  const std::size_t n =
+      static_cast<std::size_t>(header->size[0]) * header->size[1] * header->size[2];
+  if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      static_cast<std::size_t>(st.st_size) != sizeof(FileHeader) + n * sizeof(Cell))
+  {
+    munmap(mapping, static_cast<std::size_t>(st.st_size));
+    return false;
+  }
+
+  mapping_ = mapping;
+  mapping_size_ = static_cast<std::size_t>(st.st_size);
+  std::copy(header->size, header->size + 3, size_);
+  origin_ = Eigen::Vector3d(header->origin[0], header->origin[1], header->origin[2]);
+  resolution_ = header->resolution;
+  // The map is only ever read after loading; the const_cast is never written through
+  cells_ = const_cast<Cell*>(reinterpret_cast<const Cell*>(header + 1));
+  return true;
+}
+
+const ReachabilityMap::Cell* ReachabilityMap::cell(const Eigen::Vector3d& point) const
+{
+  std::size_t idx;
+  return index(point, idx) ? &cells_[idx] : nullptr;
+}
+
+bool ReachabilityMap::isReachable(const Eigen::Isometry3d& tool_pose,
+                                  double min_manipulability) const
+{
+  const Cell* c = cell(tool_pose.translation());
+  if (!c || c->manipulability < min_manipulability)
+    return false;
+  return (c->direction_mask & (1u << directionBin(tool_pose.linear().col(2)))) != 0;
+}
+
+bool ReachabilityMap::canWeld(const std::vector<Eigen::Isometry3d>& seam,
+                              const Eigen::Isometry3d& placement, double min_manipulability,
+                              std::size_t* failed_index) const
+{
+  for (std::size_t i = 0; i < seam.size(); ++i)
+  {
+    if (!isReachable(placement * seam[i], min_manipulability))
+    {
+      if (failed_index)
+        *failed_index = i;
+      return false;
+    }
+  }
+  return true;
+}
+
+double ReachabilityMap::coverage() const
+{
+  if (!cells_)
+    return 0.0;
+  const std::size_t n = static_cast<std::size_t>(size_[0]) * size_[1] * size_[2];
+  const auto reached =
+      std::count_if(cells_, cells_ + n, [](const Cell& c) { return c.direction_mask != 0; });
+  return static_cast<double>(reached) / static_cast<double>(n);
+}
+}  // namespace welding_demo
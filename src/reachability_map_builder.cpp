@@ -0,0 +1,107 @@
+// Offline tool that samples the joint space of the planning group and stores a voxelized
+// reachability map of the tool link. Run it with the same robot_description parameters as
+// welding_demo_node, e.g. by adding it to the launch file or with --params-file.
+
+#include <rclcpp/rclcpp.hpp>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_state/robot_state.h>
+#include <random_numbers/random_numbers.h>
+
+#include <welding_demo/reachability_map.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <thread>
+
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("reachability_map_builder");
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::NodeOptions node_options;
+  node_options.automatically_declare_parameters_from_overrides(true);
+  auto node = rclcpp::Node::make_shared("reachability_map_builder", node_options);
+
+  const std::string group =
+      node->get_parameter_or<std::string>("planning_group", "ur_manipulator");
+  const std::string tool_link = node->get_parameter_or<std::string>("tool_link", "tool0");
+  const std::string output = node->get_parameter_or<std::string>("output", "reachability.map");
+  const double resolution = node->get_parameter_or("resolution", 0.02);
+  const double reach = node->get_parameter_or("reach", 1.0);
+  const int64_t samples = node->get_parameter_or<int64_t>("samples", 20000000);
+  // At least one thread, zero or negative counts would never advance the sampling loop
+  const int64_t threads = std::max<int64_t>(
+      1, node->get_parameter_or<int64_t>(
+             "threads", static_cast<int64_t>(std::max(1u, std::thread::hardware_concurrency()))));
+
+  robot_model_loader::RobotModelLoader loader(node, "robot_description");
+  const moveit::core::RobotModelConstPtr& robot_model = loader.getModel();
+  if (!robot_model)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not load the robot model");
+    rclcpp::shutdown();
+    return 1;
+  }
+  const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup(group);
+  const moveit::core::LinkModel* tool = robot_model->getLinkModel(tool_link);
+  if (!jmg || !tool)
+  {
+    RCLCPP_ERROR(LOGGER, "Unknown planning group '%s' or tool link '%s'", group.c_str(),
+                 tool_link.c_str());
+    rclcpp::shutdown();
+    return 1;
+  }
+
+  const Eigen::AlignedBox3d bounds(Eigen::Vector3d::Constant(-reach),
+                                   Eigen::Vector3d::Constant(reach));
+  RCLCPP_INFO(LOGGER, "Sampling %" PRId64 " configurations of '%s' on %" PRId64 " threads", samples,
+              group.c_str(), threads);
+
+  // Every thread fills its own map, the maps are merged at the end, so no locking is needed
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<welding_demo::ReachabilityMap> partial(static_cast<std::size_t>(threads));
+  std::vector<std::thread> workers;
+  for (int64_t t = 0; t < threads; ++t)
+  {
+    workers.emplace_back([&, t]() {
+      welding_demo::ReachabilityMap& map = partial[static_cast<std::size_t>(t)];
+      map.allocate(bounds, resolution);
+      moveit::core::RobotState state(robot_model);
+      random_numbers::RandomNumberGenerator rng(static_cast<uint32_t>(t + 1));
+      Eigen::MatrixXd jacobian;
+      for (int64_t i = t; i < samples; i += threads)
+      {
+        state.setToRandomPositions(jmg, rng);
+        state.updateLinkTransforms();
+        // Manipulability of the tool link the map is built for, not of the group's tip
+        if (!state.getJacobian(jmg, tool, Eigen::Vector3d::Zero(), jacobian))
+          continue;
+        const double manipulability =
+            std::sqrt(std::max(0.0, (jacobian * jacobian.transpose()).determinant()));
+        map.addSample(state.getGlobalLinkTransform(tool), manipulability);
+      }
+    });
+  }
+  for (auto& worker : workers)
+    worker.join();
+
+  welding_demo::ReachabilityMap& map = partial.front();
+  for (std::size_t i = 1; i < partial.size(); ++i)
+    map.merge(partial[i]);
+
+  const double elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  RCLCPP_INFO(LOGGER, "Sampling finished in %.1f s, %.1f%% of the voxels are reachable", elapsed,
+              map.coverage() * 100.0);
+
+  if (!map.save(output))
+  {
+    RCLCPP_ERROR(LOGGER, "Could not write reachability map to '%s'", output.c_str());
+    rclcpp::shutdown();
+    return 1;
+  }
+  RCLCPP_INFO(LOGGER, "Reachability map written to '%s'", output.c_str());
+  rclcpp::shutdown();
+  return 0;
+}
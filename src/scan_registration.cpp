@@ -0,0 +1,242 @@
+#include <welding_demo/scan_registration.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <thread>
+
+#include <Eigen/Eigenvalues>
+#include <Eigen/SVD>
+
+namespace welding_demo
+{
+namespace
+{
+// Centroid and principal axes (columns, by decreasing variance, right-handed) of a cloud
+void principalAxes(const Eigen::Ref<const Eigen::Matrix3Xf>& points, Eigen::Vector3d& centroid,
+                   Eigen::Matrix3d& axes)
+{
+  const Eigen::Matrix3Xd p = points.cast<double>();
+  centroid = p.rowwise().mean();
+  const Eigen::Matrix3Xd centered = p.colwise() - centroid;
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(centered * centered.transpose());
+  axes = solver.eigenvectors().rowwise().reverse();
+  if (axes.determinant() < 0.0)
+    axes.col(2) = -axes.col(2);
+}
+
+// Sums for the point-to-point alignment of scan points (moved by the current estimate) to their
+// nearest model points
+struct Accumulator
+{
+  Eigen::Vector3d scan_sum = Eigen::Vector3d::Zero();
+  Eigen::Vector3d model_sum = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d cross = Eigen::Matrix3d::Zero();  // sum of scan * model^T
+  double distance_sq = 0.0;
+  std::size_t matches = 0;
+
+  void add(const Accumulator& other)
+  {
+    scan_sum += other.scan_sum;
+    model_sum += other.model_sum;
+    cross += other.cross;
+    distance_sq += other.distance_sq;
+    matches += other.matches;
+  }
+};
+}  // namespace
+
+ScanRegistration::ScanRegistration(Eigen::Matrix3Xf model)
+  : model_(std::move(model)), split_axis_(static_cast<std::size_t>(model_.cols()), 0)
+{
+  if (model_.cols() == 0)
+    return;
+  principalAxes(model_, model_centroid_, model_axes_);
+  build(0, model_.cols());
+}
+
+void ScanRegistration::build(Eigen::Index begin, Eigen::Index end)
+{
+  if (end - begin <= 1)
+    return;
+  // Split along the widest extent of the range
+  const Eigen::Vector3f extent = model_.middleCols(begin, end - begin).rowwise().maxCoeff() -
+                                 model_.middleCols(begin, end - begin).rowwise().minCoeff();
+  int axis;
+  extent.maxCoeff(&axis);
+  const Eigen::Index middle = begin + (end - begin) / 2;
+  std::vector<Eigen::Index> order(static_cast<std::size_t>(end - begin));
+  std::iota(order.begin(), order.end(), begin);
+  std::nth_element(order.begin(), order.begin() + (middle - begin), order.end(),
+                   [&](Eigen::Index a, Eigen::Index b) {
+                     return model_(axis, a) < model_(axis, b);
+                   });
+  Eigen::Matrix3Xf range(3, end - begin);
+  for (Eigen::Index i = 0; i < end - begin; ++i)
+    range.col(i) = model_.col(order[static_cast<std::size_t>(i)]);
+  model_.middleCols(begin, end - begin) = range;
+  split_axis_[static_cast<std::size_t>(middle)] = static_cast<uint8_t>(axis);
+  build(begin, middle);
+  build(middle + 1, end);
+}
+
+Eigen::Index ScanRegistration::nearest(const Eigen::Vector3f& query, float& best_distance_sq) const
+{
+  struct Range
+  {
+    Eigen::Index begin, end;
+    float plane_distance_sq;  // lower bound for points of the range
+  };
+  Range stack[64];
+  int top = 0;
+  stack[top++] = { 0, model_.cols(), 0.0f };
+  Eigen::Index best = -1;
+  while (top > 0)
+  {
+    const Range range = stack[--top];
+    if (range.begin >= range.end || range.plane_distance_sq >= best_distance_sq)
+      continue;
+    const Eigen::Index middle = range.begin + (range.end - range.begin) / 2;
+    const float distance_sq = (model_.col(middle) - query).squaredNorm();
+    if (distance_sq < best_distance_sq)
+    {
+      best_distance_sq = distance_sq;
+      best = middle;
+    }
+    const int axis = split_axis_[static_cast<std::size_t>(middle)];
+    const float delta = query[axis] - model_(axis, middle);
+    const Range lower{ range.begin, middle, 0.0f };
+    const Range upper{ middle + 1, range.end, 0.0f };
+    // The far side is pushed first so the near side is searched first
+    Range far_side = delta < 0.0f ? upper : lower;
+    far_side.plane_distance_sq = std::max(range.plane_distance_sq, delta * delta);
+    stack[top++] = far_side;
+    stack[top++] = delta < 0.0f ? Range{ lower.begin, lower.end, range.plane_distance_sq } :
+                                  Range{ upper.begin, upper.end, range.plane_distance_sq };
+  }
+  return best;
+}
+
+RegistrationResult ScanRegistration::align(const Eigen::Ref<const Eigen::Matrix3Xf>& scan,
+                                           const Eigen::Isometry3d& initial_pose,
+                                           const RegistrationOptions& options) const
+{
+  const auto start = std::chrono::steady_clock::now();
+  RegistrationResult result;
+  result.part_pose = initial_pose;
+  if (model_.cols() == 0 || scan.cols() < 3)
+    return result;
+
+  const Eigen::Index stride =
+      std::max<Eigen::Index>(1, scan.cols() / std::max<Eigen::Index>(1, options.max_points));
+  const Eigen::Index used = (scan.cols() + stride - 1) / stride;
+  const std::size_t threads = std::max<std::size_t>(
+      1, std::min<std::size_t>(options.threads > 0 ?
+                                   options.threads :
+                                   std::max(1u, std::thread::hardware_concurrency()),
+                               static_cast<std::size_t>(used) / 1000));
+  const float max_distance_sq = options.max_distance * options.max_distance;
+
+  // Matches of the strided scan points moved into the model frame by ``scan_to_model``
+  auto match = [&](const Eigen::Isometry3d& scan_to_model) {
+    const Eigen::Matrix3f rotation = scan_to_model.linear().cast<float>();
+    const Eigen::Vector3f translation = scan_to_model.translation().cast<float>();
+    std::vector<Accumulator> partial(threads);
+    auto work = [&](std::size_t t) {
+      Accumulator& sum = partial[t];
+      const Eigen::Index end = used * static_cast<Eigen::Index>(t + 1) / threads;
+      for (Eigen::Index i = used * static_cast<Eigen::Index>(t) / threads; i < end; ++i)
+      {
+        const Eigen::Vector3f p = rotation * scan.col(i * stride) + translation;
+        float distance_sq = max_distance_sq;
+        const Eigen::Index m = nearest(p, distance_sq);
+        if (m < 0)
+          continue;
+        const Eigen::Vector3d pd = p.cast<double>();
+        const Eigen::Vector3d md = model_.col(m).cast<double>();
+        sum.scan_sum += pd;
+        sum.model_sum += md;
+        sum.cross += pd * md.transpose();
+        sum.distance_sq += distance_sq;
+        ++sum.matches;
+      }
+    };
+    std::vector<std::thread> workers;
+    for (std::size_t t = 1; t < threads; ++t)
+      workers.emplace_back(work, t);
+    work(0);
+    for (auto& worker : workers)
+      worker.join();
+    for (std::size_t t = 1; t < threads; ++t)
+      partial[0].add(partial[t]);
+    return partial[0];
+  };
+
+  // Coarse stage: the initial guess competes with the principal axis alignments, in all four
+  // right-handed sign combinations of the axes. The candidate matching most points wins.
+  Eigen::Isometry3d estimate = initial_pose.inverse();
+  if (options.coarse)
+  {
+    std::size_t best_matches = match(estimate).matches;
+    Eigen::Vector3d scan_centroid;
+    Eigen::Matrix3d scan_axes;
+    principalAxes(scan, scan_centroid, scan_axes);
+    const double signs[4][3] = { { 1, 1, 1 }, { -1, -1, 1 }, { -1, 1, -1 }, { 1, -1, -1 } };
+    for (const auto& s : signs)
+    {
+      Eigen::Isometry3d candidate = Eigen::Isometry3d::Identity();
+      candidate.linear() =
+          model_axes_ * Eigen::Vector3d(s[0], s[1], s[2]).asDiagonal() * scan_axes.transpose();
+      candidate.translation() = model_centroid_ - candidate.linear() * scan_centroid;
+      const std::size_t matches = match(candidate).matches;
+      if (matches > best_matches)
+      {
+        best_matches = matches;
+        estimate = candidate;
+      }
+    }
+  }
+
+  // Point-to-point ICP, every step is the closed-form (Kabsch) alignment of the current matches
+  Accumulator sum;
+  for (result.iterations = 0; result.iterations < options.max_iterations; ++result.iterations)
+  {
+    sum = match(estimate);
+    if (sum.matches < 3)
+      break;
+    const double n = static_cast<double>(sum.matches);
+    const Eigen::Vector3d scan_mean = sum.scan_sum / n;
+    const Eigen::Vector3d model_mean = sum.model_sum / n;
+    const Eigen::Matrix3d covariance = sum.cross - n * scan_mean * model_mean.transpose();
+    Eigen::JacobiSVD<Eigen::Matrix3d> svd(covariance, Eigen::ComputeFullU | Eigen::ComputeFullV);
+    Eigen::Matrix3d rotation = svd.matrixV() * svd.matrixU().transpose();
+    if (rotation.determinant() < 0.0)
+    {
+      Eigen::Matrix3d v = svd.matrixV();
+      v.col(2) = -v.col(2);
+      rotation = v * svd.matrixU().transpose();
+    }
+    Eigen::Isometry3d step = Eigen::Isometry3d::Identity();
+    step.linear() = rotation;
+    step.translation() = model_mean - rotation * scan_mean;
+    estimate = step * estimate;
+    if (step.translation().norm() < options.translation_tolerance &&
+        Eigen::AngleAxisd(rotation).angle() < options.rotation_tolerance)
+    {
+      result.converged = true;
+      ++result.iterations;
+      sum = match(estimate);
+      break;
+    }
+  }
+
+  result.part_pose = estimate.inverse();
+  result.rmse = sum.matches > 0 ? std::sqrt(sum.distance_sq / sum.matches) : 0.0;
+  result.fitness = static_cast<double>(sum.matches) / static_cast<double>(used);
+  result.elapsed_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+}  // namespace welding_demo
@@ -0,0 +1,103 @@
+#include <welding_demo/seam_buffer.hpp>
+
+#include <algorithm>
+
+namespace welding_demo
+{
+void SeamBuffer::reserveMore(Eigen::Index count)
+{
+  const Eigen::Index needed = pose_count_ + count;
+  if (needed <= batch_.size())
+    return;
+  const Eigen::Index capacity = std::max(needed, 2 * batch_.size());
+  batch_.positions.conservativeResize(Eigen::NoChange, capacity);
+  batch_.orientations.conservativeResize(Eigen::NoChange, capacity);
+}
+
+void SeamBuffer::finishSeam(const std::string& name)
+{
+  // The name string of a previous cycle is overwritten, which reuses its storage
+  if (seam_count_ < names_.size())
+    names_[seam_count_] = name;
+  else
+    names_.push_back(name);
+  ++seam_count_;
+  offsets_.push_back(pose_count_);
+}
+
+void SeamBuffer::add(const std::string& name, const PoseBatch& poses)
+{
+  reserveMore(poses.size());
+  batch_.positions.middleCols(pose_count_, poses.size()) = poses.positions;
+  batch_.orientations.middleCols(pose_count_, poses.size()) = poses.orientations;
+  pose_count_ += poses.size();
+  finishSeam(name);
+}
+
+void SeamBuffer::add(const std::string& name,
+                     const std::vector<geometry_msgs::msg::Pose>& waypoints)
+{
+  const auto count = static_cast<Eigen::Index>(waypoints.size());
+  reserveMore(count);
+  for (const auto& pose : waypoints)
+  {
+    batch_.positions.col(pose_count_) << pose.position.x, pose.position.y, pose.position.z;
+    batch_.orientations.col(pose_count_) << pose.orientation.w, pose.orientation.x,
+        pose.orientation.y, pose.orientation.z;
+    ++pose_count_;
+  }
+  finishSeam(name);
+}
+
+void SeamBuffer::transform(const Eigen::Isometry3d& transform)
+{
+  auto positions = batch_.positions.leftCols(pose_count_);
+  positions = (transform.linear() * positions).colwise() + transform.translation();
+  const Eigen::Quaterniond inverse(transform.linear().transpose());
+  const QuaternionBatch orientations = batch_.orientations.leftCols(pose_count_);
+  const QuaternionBatch rotations =
+      Eigen::Vector4d(inverse.w(), inverse.x(), inverse.y(), inverse.z())
+          .replicate(1, pose_count_);
+  QuaternionBatch rotated;
+  compose(orientations, rotations, rotated);
+  batch_.orientations.leftCols(pose_count_) = rotated;
+}
+
+Eigen::Isometry3d SeamBuffer::columnPose(Eigen::Index column) const
+{
+  const Eigen::Quaterniond q(batch_.orientations(0, column), batch_.orientations(1, column),
+                             batch_.orientations(2, column), batch_.orientations(3, column));
+  return Eigen::Translation3d(batch_.positions.col(column)) * q.normalized();
+}
+
+void SeamBuffer::waypoints(std::size_t seam, bool reversed,
+                           std::vector<geometry_msgs::msg::Pose>& poses) const
+{
+  const Eigen::Index begin = offsets_[seam];
+  const Eigen::Index count = offsets_[seam + 1] - begin;
+  poses.resize(static_cast<std::size_t>(count));
+  for (Eigen::Index i = 0; i < count; ++i)
+  {
+    const Eigen::Index column = reversed ? begin + count - 1 - i : begin + i;
+    auto& pose = poses[static_cast<std::size_t>(i)];
+    pose.position.x = batch_.positions(0, column);
+    pose.position.y = batch_.positions(1, column);
+    pose.position.z = batch_.positions(2, column);
+    pose.orientation.w = batch_.orientations(0, column);
+    pose.orientation.x = batch_.orientations(1, column);
+    pose.orientation.y = batch_.orientations(2, column);
+    pose.orientation.z = batch_.orientations(3, column);
+  }
+}
+
+void SeamBuffer::transforms(std::size_t seam, bool reversed,
+                            std::vector<Eigen::Isometry3d>& transforms) const
+{
+  const Eigen::Index begin = offsets_[seam];
+  const Eigen::Index count = offsets_[seam + 1] - begin;
+  transforms.resize(static_cast<std::size_t>(count));
+  for (Eigen::Index i = 0; i < count; ++i)
+    transforms[static_cast<std::size_t>(i)] =
+        columnPose(reversed ? begin + count - 1 - i : begin + i);
+}
+}  // namespace welding_demo
@@ -0,0 +1,44 @@
+#include <welding_demo/seam_endpoints.hpp>
+
+namespace welding_demo
+{
+std::size_t solveSeamEndpoints(const SeamBuffer& seams, const moveit::core::RobotState& home,
+                               const moveit::core::JointModelGroup* group,
+                               std::vector<Eigen::VectorXd>& configurations, double ik_timeout)
+{
+  Eigen::VectorXd home_positions;
+  home.copyJointGroupPositions(group, home_positions);
+  configurations.assign(2 * seams.size() + 1, home_positions);
+
+  std::size_t failures = 0;
+  moveit::core::RobotState state(home);
+  for (std::size_t i = 0; i < seams.size(); ++i)
+  {
+    const std::size_t count = seams.waypointCount(i);
+    if (count == 0)
+      continue;
+    const std::size_t ends[2] = { 0, count - 1 };
+    for (std::size_t e = 0; e < 2; ++e)
+    {
+      state.setJointGroupPositions(group, home_positions);
+      if (state.setFromIK(group, seams.pose(i, ends[e]), ik_timeout))
+        state.copyJointGroupPositions(group, configurations[2 * i + e]);
+      else
+        ++failures;
+    }
+  }
+  return failures;
+}
+
+Eigen::VectorXd maxJointVelocities(const moveit::core::JointModelGroup* group,
+                                   double default_velocity)
+{
+  std::vector<double> velocities;
+  for (const moveit::core::JointModel::Bounds* bounds : group->getActiveJointModelsBounds())
+    for (const moveit::core::VariableBounds& b : *bounds)
+      velocities.push_back(b.velocity_bounded_ && b.max_velocity_ > 0.0 ? b.max_velocity_ :
+                                                                           default_velocity);
+  return Eigen::Map<Eigen::VectorXd>(velocities.data(),
+                                     static_cast<Eigen::Index>(velocities.size()));
+}
+}  // namespace welding_demo
@@ -0,0 +1,419 @@
+#include <welding_demo/seam_extraction.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <Eigen/Eigenvalues>
+#include <Eigen/Geometry>
+
+namespace welding_demo
+{
+namespace
+{
+// Largest plane raster searched for gaps, larger planes are skipped
+constexpr std::size_t MAX_GAP_RASTER_CELLS = std::size_t(1) << 22;
+
+std::size_t threadCount(const SeamExtractionOptions& options)
+{
+  return options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Points of ``indices`` within ``threshold`` of the plane, in their original order
+std::vector<int> collectInliers(const Eigen::Ref<const Eigen::Matrix3Xf>& points,
+                                const std::vector<int>& indices, const Eigen::Vector3f& normal,
+                                float offset, float threshold, std::size_t threads)
+{
+  threads = std::max<std::size_t>(1, std::min(threads, indices.size() / 10000));
+  std::vector<std::vector<int>> chunks(threads);
+  auto work = [&](std::size_t t) {
+    const std::size_t end = indices.size() * (t + 1) / threads;
+    for (std::size_t i = indices.size() * t / threads; i < end; ++i)
+      if (std::abs(normal.dot(points.col(indices[i])) + offset) < threshold)
+        chunks[t].push_back(indices[i]);
+  };
+  std::vector<std::thread> workers;
+  for (std::size_t t = 1; t < threads; ++t)
+    workers.emplace_back(work, t);
+  work(0);
+  for (auto& worker : workers)
+    worker.join();
+
+  std::vector<int> inliers = std::move(chunks[0]);
+  for (std::size_t t = 1; t < threads; ++t)
+    inliers.insert(inliers.end(), chunks[t].begin(), chunks[t].end());
+  return inliers;
+}
+
+// Least-squares plane through the inliers: the centroid and the direction of least variance
+void fitPlane(const Eigen::Ref<const Eigen::Matrix3Xf>& points, const std::vector<int>& inliers,
+              Eigen::Vector3f& normal, float& offset)
+{
+  Eigen::Vector3d centroid = Eigen::Vector3d::Zero();
+  for (int i : inliers)
+    centroid += points.col(i).cast<double>();
+  centroid /= static_cast<double>(inliers.size());
+  Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+  for (int i : inliers)
+  {
+    const Eigen::Vector3d d = points.col(i).cast<double>() - centroid;
+    covariance += d * d.transpose();
+  }
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+  normal = solver.eigenvectors().col(0).cast<float>();  // eigenvalues are sorted increasingly
+  offset = -normal.dot(centroid.cast<float>());
+}
+
+// Contiguous runs of ``step`` sized bins along a line that are covered by ``support`` positions.
+// Calls ``emit(start, length)`` for every run of at least ``min_length``.
+template <typename Emit>
+void supportedRuns(const std::vector<float>& support, float step, float min_length, Emit emit)
+{
+  if (support.empty())
+    return;
+  const auto [lo, hi] = std::minmax_element(support.begin(), support.end());
+  const float t_min = *lo;
+  const auto bins = static_cast<std::size_t>((*hi - t_min) / step) + 1;
+  std::vector<unsigned char> occupied(bins, 0);
+  for (float t : support)
+    occupied[std::min(bins - 1, static_cast<std::size_t>((t - t_min) / step))] = 1;
+  for (std::size_t first = 0; first < bins;)
+  {
+    if (!occupied[first])
+    {
+      ++first;
+      continue;
+    }
+    std::size_t last = first;
+    while (last + 1 < bins && occupied[last + 1])
+      ++last;
+    const float length = (last + 1 - first) * step;
+    if (length >= min_length)
+      emit(t_min + first * step, length);
+    first = last + 1;
+  }
+}
+
+// Seam waypoints every ``step`` (or closer) from ``start`` over ``length`` along a line
+void sampleLine(const Eigen::Vector3f& origin, const Eigen::Vector3f& direction, float start,
+                float length, float step, const Eigen::Vector3f& normal, PoseBatch& poses)
+{
+  const auto count = static_cast<Eigen::Index>(std::lround(length / step)) + 1;
+  poses.resize(count);
+  const Eigen::Array<double, 1, Eigen::Dynamic> t =
+      Eigen::Array<double, 1, Eigen::Dynamic>::LinSpaced(count, start, start + length);
+  for (Eigen::Index k = 0; k < 3; ++k)
+    poses.positions.row(k).array() = origin[k] + t * direction[k];
+  // All waypoints of a line share the orientation of its normal
+  QuaternionBatch orientation;
+  seamOrientations(normal.cast<double>(), orientation);
+  poses.orientations = orientation.replicate(1, count);
+}
+
+// Butt seams between coplanar plates. RANSAC merges the plates into one plane; the seam is the
+// gap between separate regions of its inliers. The inliers are rasterized in the plane and the
+// regions labeled (4-connected). Every region cell next to an empty cell looks for the closest
+// cell of another region within ``max_gap``; the midpoints of these pairs are fitted with a line.
+// ``poses`` is the scratch batch the seams are sampled into.
+void extractGapSeams(const Eigen::Ref<const Eigen::Matrix3Xf>& points, const ScanPlane& plane,
+                     std::size_t plane_index, const SeamExtractionOptions& options,
+                     PoseBatch& poses, SeamBuffer& seams)
+{
+  const float cell = options.gap_resolution;
+  if (options.max_gap <= 0.0f || cell <= 0.0f || plane.inliers.empty())
+    return;
+  const Eigen::Vector3f u = plane.normal.unitOrthogonal();
+  const Eigen::Vector3f v = plane.normal.cross(u);
+  const Eigen::Vector3f origin = -plane.offset * plane.normal;
+  Eigen::Matrix2Xf uv(2, static_cast<Eigen::Index>(plane.inliers.size()));
+  for (std::size_t k = 0; k < plane.inliers.size(); ++k)
+  {
+    const Eigen::Vector3f d = points.col(plane.inliers[k]) - origin;
+    uv.col(static_cast<Eigen::Index>(k)) << u.dot(d), v.dot(d);
+  }
+  const Eigen::Vector2f lo = uv.rowwise().minCoeff();
+  const Eigen::Vector2f extent = uv.rowwise().maxCoeff() - lo;
+  const auto width = static_cast<std::ptrdiff_t>(extent.x() / cell) + 1;
+  const auto height = static_cast<std::ptrdiff_t>(extent.y() / cell) + 1;
+  if (static_cast<std::size_t>(width * height) > MAX_GAP_RASTER_CELLS)
+    return;
+
+  // -1 empty, 0 occupied, > 0 region label
+  std::vector<int> raster(static_cast<std::size_t>(width * height), -1);
+  for (Eigen::Index k = 0; k < uv.cols(); ++k)
+  {
+    const auto x = static_cast<std::ptrdiff_t>((uv(0, k) - lo.x()) / cell);
+    const auto y = static_cast<std::ptrdiff_t>((uv(1, k) - lo.y()) / cell);
+    raster[static_cast<std::size_t>(std::min(y, height - 1) * width + std::min(x, width - 1))] = 0;
+  }
+  const std::ptrdiff_t offsets[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+  auto inside = [&](std::ptrdiff_t x, std::ptrdiff_t y) {
+    return x >= 0 && y >= 0 && x < width && y < height;
+  };
+  int labels = 0;
+  std::vector<std::ptrdiff_t> queue;
+  for (std::ptrdiff_t start = 0; start < width * height; ++start)
+  {
+    if (raster[static_cast<std::size_t>(start)] != 0)
+      continue;
+    raster[static_cast<std::size_t>(start)] = ++labels;
+    queue.assign(1, start);
+    while (!queue.empty())
+    {
+      const std::ptrdiff_t c = queue.back();
+      queue.pop_back();
+      for (const auto& o : offsets)
+      {
+        const std::ptrdiff_t x = c % width + o[0], y = c / width + o[1];
+        if (inside(x, y) && raster[static_cast<std::size_t>(y * width + x)] == 0)
+        {
+          raster[static_cast<std::size_t>(y * width + x)] = labels;
+          queue.push_back(y * width + x);
+        }
+      }
+    }
+  }
+  if (labels < 2)
+    return;
+
+  // Gap midpoints between every pair of regions
+  const auto reach = static_cast<std::ptrdiff_t>(std::ceil(options.max_gap / cell)) + 1;
+  const float max_gap_cells = options.max_gap / cell + 1.0f;
+  std::map<std::pair<int, int>, std::vector<Eigen::Vector2f>> midpoints;
+  for (std::ptrdiff_t c = 0; c < width * height; ++c)
+  {
+    const int label = raster[static_cast<std::size_t>(c)];
+    const std::ptrdiff_t cx = c % width, cy = c / width;
+    bool edge = false;
+    for (const auto& o : offsets)
+      edge = edge || (inside(cx + o[0], cy + o[1]) &&
+                      raster[static_cast<std::size_t>((cy + o[1]) * width + cx + o[0])] < 0);
+    if (label <= 0 || !edge)
+      continue;
+    int other = 0;
+    float best = max_gap_cells * max_gap_cells;
+    Eigen::Vector2f partner;
+    for (std::ptrdiff_t y = std::max<std::ptrdiff_t>(0, cy - reach);
+         y <= std::min(height - 1, cy + reach); ++y)
+      for (std::ptrdiff_t x = std::max<std::ptrdiff_t>(0, cx - reach);
+           x <= std::min(width - 1, cx + reach); ++x)
+      {
+        const int candidate = raster[static_cast<std::size_t>(y * width + x)];
+        const auto distance = static_cast<float>((x - cx) * (x - cx) + (y - cy) * (y - cy));
+        // Each pair of regions is collected from the side of the lower label only
+        if (candidate > label && distance < best)
+        {
+          best = distance;
+          other = candidate;
+          partner = Eigen::Vector2f(static_cast<float>(x), static_cast<float>(y));
+        }
+      }
+    if (other > 0)
+      midpoints[std::make_pair(label, other)].push_back(
+          lo + cell * (0.5f * (Eigen::Vector2f(static_cast<float>(cx), static_cast<float>(cy)) +
+                               partner) +
+                       Eigen::Vector2f::Constant(0.5f)));
+  }
+
+  std::size_t segment = 0;
+  for (const auto& pair : midpoints)
+  {
+    const std::vector<Eigen::Vector2f>& m = pair.second;
+    if (m.size() < 2)
+      continue;
+    Eigen::Vector2f centroid = Eigen::Vector2f::Zero();
+    for (const auto& p : m)
+      centroid += p;
+    centroid /= static_cast<float>(m.size());
+    Eigen::Matrix2f covariance = Eigen::Matrix2f::Zero();
+    for (const auto& p : m)
+      covariance += (p - centroid) * (p - centroid).transpose();
+    covariance /= static_cast<float>(m.size());
+    const Eigen::SelfAdjointEigenSolver<Eigen::Matrix2f> solver(covariance);
+    // Regions touching along a curved or ragged boundary are not a straight butt joint
+    if (std::sqrt(std::max(0.0f, solver.eigenvalues()[0])) > options.max_gap)
+      continue;
+    const Eigen::Vector2f direction2 = solver.eigenvectors().col(1);
+    std::vector<float> support;
+    support.reserve(m.size());
+    for (const auto& p : m)
+      support.push_back((p - centroid).dot(direction2));
+
+    const Eigen::Vector3f line_origin = origin + centroid.x() * u + centroid.y() * v;
+    const Eigen::Vector3f direction = (direction2.x() * u + direction2.y() * v).normalized();
+    supportedRuns(support, options.sample_step, options.min_length,
+                  [&](float start, float length) {
+                    sampleLine(line_origin, direction, start, length, options.sample_step,
+                               plane.normal, poses);
+                    seams.add("plane" + std::to_string(plane_index) + "_gap_" +
+                                  std::to_string(segment++),
+                              poses);
+                  });
+  }
+}
+}  // namespace
+
+std::vector<ScanPlane> segmentPlanes(const Eigen::Ref<const Eigen::Matrix3Xf>& points,
+                                     const SeamExtractionOptions& options)
+{
+  const std::size_t threads = threadCount(options);
+  std::vector<int> remaining(static_cast<std::size_t>(points.cols()));
+  for (std::size_t i = 0; i < remaining.size(); ++i)
+    remaining[i] = static_cast<int>(i);
+
+  std::vector<ScanPlane> planes;
+  std::mt19937 rng(42);
+  std::vector<int> sample;
+  while (planes.size() < options.max_planes && remaining.size() >= options.min_plane_points)
+  {
+    // Score the hypotheses on a random subset, it is representative long before it is large
+    if (remaining.size() <= options.sample_size)
+      sample = remaining;
+    else
+    {
+      sample.resize(options.sample_size);
+      std::uniform_int_distribution<std::size_t> pick(0, remaining.size() - 1);
+      for (int& s : sample)
+        s = remaining[pick(rng)];
+    }
+
+    struct Hypothesis
+    {
+      Eigen::Vector3f normal;
+      float offset;
+      std::size_t score = 0;
+    };
+    std::vector<Hypothesis> best(threads);
+    const uint32_t round_seed = static_cast<uint32_t>(rng());
+    std::vector<std::thread> workers;
+    for (std::size_t t = 0; t < threads; ++t)
+      workers.emplace_back([&, t]() {
+        std::mt19937 local(round_seed + static_cast<uint32_t>(t));
+        std::uniform_int_distribution<std::size_t> pick(0, sample.size() - 1);
+        for (std::size_t h = t; h < options.iterations; h += threads)
+        {
+          const Eigen::Vector3f a = points.col(sample[pick(local)]);
+          const Eigen::Vector3f b = points.col(sample[pick(local)]);
+          const Eigen::Vector3f c = points.col(sample[pick(local)]);
+          Eigen::Vector3f normal = (b - a).cross(c - a);
+          if (normal.norm() < 1e-9f)
+            continue;  // degenerate or repeated points
+          normal.normalize();
+          const float offset = -normal.dot(a);
+          std::size_t score = 0;
+          for (int s : sample)
+            score += std::abs(normal.dot(points.col(s)) + offset) < options.distance_threshold;
+          if (score > best[t].score)
+            best[t] = { normal, offset, score };
+        }
+      });
+    for (auto& worker : workers)
+      worker.join();
+
+    const Hypothesis& winner = *std::max_element(
+        best.begin(), best.end(),
+        [](const Hypothesis& a, const Hypothesis& b) { return a.score < b.score; });
+    if (winner.score * remaining.size() < options.min_plane_points * sample.size())
+      break;
+
+    ScanPlane plane{ winner.normal, winner.offset, {} };
+    plane.inliers = collectInliers(points, remaining, plane.normal, plane.offset,
+                                   options.distance_threshold, threads);
+    fitPlane(points, plane.inliers, plane.normal, plane.offset);
+    plane.inliers = collectInliers(points, remaining, plane.normal, plane.offset,
+                                   options.distance_threshold, threads);
+    if (plane.inliers.size() < options.min_plane_points)
+      break;
+    if (plane.normal.dot(options.viewpoint) + plane.offset < 0.0f)
+    {
+      plane.normal = -plane.normal;
+      plane.offset = -plane.offset;
+    }
+
+    // Both lists are in scan order, remove the inliers in one merge pass
+    std::vector<int> rest;
+    rest.reserve(remaining.size() - plane.inliers.size());
+    std::set_difference(remaining.begin(), remaining.end(), plane.inliers.begin(),
+                        plane.inliers.end(), std::back_inserter(rest));
+    remaining.swap(rest);
+    planes.push_back(std::move(plane));
+  }
+  return planes;
+}
+
+void extractSeams(const Eigen::Ref<const Eigen::Matrix3Xf>& points,
+                  const std::vector<ScanPlane>& planes, const SeamExtractionOptions& options,
+                  SeamBuffer& seams)
+{
+  const float step = options.sample_step;
+  PoseBatch poses;
+  for (std::size_t i = 0; i < planes.size(); ++i)
+    for (std::size_t j = i + 1; j < planes.size(); ++j)
+    {
+      const ScanPlane& a = planes[i];
+      const ScanPlane& b = planes[j];
+      Eigen::Vector3f direction = a.normal.cross(b.normal);
+      if (std::asin(std::min(1.0f, direction.norm())) < options.min_angle)
+        continue;  // nearly parallel, coplanar plates are handled by extractGapSeams()
+      direction.normalize();
+      Eigen::Matrix3f system;
+      system << a.normal.transpose(), b.normal.transpose(), direction.transpose();
+      const Eigen::Vector3f origin =
+          system.partialPivLu().solve(Eigen::Vector3f(-a.offset, -b.offset, 0.0f));
+
+      // Positions along the line supported by points of either plane
+      std::vector<float> support[2];
+      const ScanPlane* pair[2] = { &a, &b };
+      for (int k = 0; k < 2; ++k)
+        for (int index : pair[k]->inliers)
+        {
+          const Eigen::Vector3f d = points.col(index) - origin;
+          const float t = d.dot(direction);
+          if ((d - t * direction).squaredNorm() < options.seam_distance * options.seam_distance)
+            support[k].push_back(t);
+        }
+      if (support[0].empty() || support[1].empty())
+        continue;
+
+      // Bins along the line that both planes reach, contiguous runs of them are seams
+      const auto [lo, hi] = std::minmax_element(support[0].begin(), support[0].end());
+      const float t_min = *lo;
+      const auto bins = static_cast<std::size_t>((*hi - t_min) / step) + 1;
+      std::vector<unsigned char> occupied(bins, 0);
+      for (int k = 0; k < 2; ++k)
+        for (float t : support[k])
+          if (t >= t_min && t < t_min + bins * step)
+            occupied[static_cast<std::size_t>((t - t_min) / step)] |= 1 << k;
+
+      const Eigen::Vector3f normal = (a.normal + b.normal).normalized();
+      std::size_t segment = 0;
+      for (std::size_t first = 0; first < bins;)
+      {
+        if (occupied[first] != 3)
+        {
+          ++first;
+          continue;
+        }
+        std::size_t last = first;
+        while (last + 1 < bins && occupied[last + 1] == 3)
+          ++last;
+        const float start = t_min + first * step;
+        const float length = (last + 1 - first) * step;
+        first = last + 1;
+        if (length < options.min_length)
+          continue;
+
+        sampleLine(origin, direction, start, length, step, normal, poses);
+        seams.add("plane" + std::to_string(i) + "_plane" + std::to_string(j) + "_" +
+                      std::to_string(segment++),
+                  poses);
+      }
+    }
+
+  for (std::size_t i = 0; i < planes.size(); ++i)
+    extractGapSeams(points, planes[i], i, options, poses, seams);
+}
+}  // namespace welding_demo
@@ -0,0 +1,130 @@
+// Benchmark of the time from a raw scan to seam poses. A synthetic scan of a weldment is
+// generated: two coplanar floor plates with a butt gap between them and a wall plate standing on
+// one of them (a fillet). The scan is cropped and downsampled, planes are segmented and seams are
+// extracted, like welding_demo_node does with every scan; the median time of every stage is
+// logged. Parameters: points (scan size), repetitions, voxel_size, gap, noise, threads.
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <welding_demo/cloud_preprocessing.hpp>
+#include <welding_demo/seam_extraction.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <random>
+
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("seam_extraction_benchmark");
+
+namespace
+{
+constexpr float PLATE_LENGTH = 0.4f;  // along y
+constexpr float PLATE_WIDTH = 0.3f;  // along x, of every floor plate
+constexpr float WALL_HEIGHT = 0.15f;
+
+// Points spread over the plates in proportion to their area, with Gaussian noise along the
+// plate normals. The butt gap is centered on x = 0, the wall stands at x = PLATE_WIDTH / 2.
+Eigen::Matrix3Xf syntheticScan(std::size_t count, float gap, float noise)
+{
+  const float wall_x = 0.5f * PLATE_WIDTH;
+  const float floor_area = 2.0f * PLATE_WIDTH * PLATE_LENGTH;
+  const float wall_area = WALL_HEIGHT * PLATE_LENGTH;
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::normal_distribution<float> jitter(0.0f, noise);
+  Eigen::Matrix3Xf points(3, static_cast<Eigen::Index>(count));
+  for (Eigen::Index i = 0; i < points.cols(); ++i)
+  {
+    const float y = (unit(rng) - 0.5f) * PLATE_LENGTH;
+    if (unit(rng) * (floor_area + wall_area) < wall_area)
+    {
+      points.col(i) << wall_x + jitter(rng), y, unit(rng) * WALL_HEIGHT;
+      continue;
+    }
+    // Left plate from -PLATE_WIDTH - gap / 2, right plate up to the wall
+    const bool left = unit(rng) < PLATE_WIDTH / (PLATE_WIDTH + wall_x - 0.5f * gap);
+    const float x = left ? -0.5f * gap - unit(rng) * PLATE_WIDTH :
+                           0.5f * gap + unit(rng) * (wall_x - 0.5f * gap);
+    points.col(i) << x, y, jitter(rng);
+  }
+  return points;
+}
+
+double median(std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  return values.empty() ? 0.0 : values[values.size() / 2];
+}
+
+double msSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::NodeOptions node_options;
+  node_options.automatically_declare_parameters_from_overrides(true);
+  auto node = rclcpp::Node::make_shared("seam_extraction_benchmark", node_options);
+
+  const int64_t points =
+      std::max<int64_t>(1000, node->get_parameter_or<int64_t>("points", 4000000));
+  const int64_t repetitions =
+      std::max<int64_t>(1, node->get_parameter_or<int64_t>("repetitions", 5));
+  const double voxel_size = node->get_parameter_or("voxel_size", 0.002);
+  const double gap = node->get_parameter_or("gap", 0.005);
+  const double noise = node->get_parameter_or("noise", 0.0003);
+  const int64_t threads = std::max<int64_t>(0, node->get_parameter_or<int64_t>("threads", 0));
+
+  welding_demo::PreprocessingOptions preprocessing;
+  preprocessing.voxel_size = static_cast<float>(voxel_size);
+  preprocessing.threads = static_cast<std::size_t>(threads);
+  welding_demo::SeamExtractionOptions extraction;
+  extraction.threads = static_cast<std::size_t>(threads);
+  extraction.viewpoint = Eigen::Vector3f(-0.5f, 0.0f, 1.0f);
+  if (voxel_size > 0.0)
+    extraction.gap_resolution = static_cast<float>(voxel_size);
+
+  RCLCPP_INFO(LOGGER, "Generating a scan of %" PRId64 " points", points);
+  const Eigen::Matrix3Xf scan = syntheticScan(static_cast<std::size_t>(points),
+                                              static_cast<float>(gap), static_cast<float>(noise));
+
+  std::vector<double> preprocessing_ms, segmentation_ms, extraction_ms, total_ms;
+  Eigen::Matrix3Xf reduced;
+  welding_demo::SeamBuffer seams;
+  std::size_t plane_count = 0;
+  for (int64_t r = 0; r < repetitions; ++r)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    welding_demo::cropAndDownsample(scan, preprocessing, reduced);
+    preprocessing_ms.push_back(msSince(start));
+
+    const auto segmentation_start = std::chrono::steady_clock::now();
+    const std::vector<welding_demo::ScanPlane> planes =
+        welding_demo::segmentPlanes(reduced, extraction);
+    segmentation_ms.push_back(msSince(segmentation_start));
+
+    const auto extraction_start = std::chrono::steady_clock::now();
+    seams.clear();
+    welding_demo::extractSeams(reduced, planes, extraction, seams);
+    extraction_ms.push_back(msSince(extraction_start));
+    total_ms.push_back(msSince(start));
+    plane_count = planes.size();
+  }
+
+  RCLCPP_INFO(LOGGER, "Reduced to %ld points, %zu planes, %zu seams",
+              static_cast<long>(reduced.cols()), plane_count, seams.size());
+  for (std::size_t i = 0; i < seams.size(); ++i)
+    RCLCPP_INFO(LOGGER, "  %s: %zu waypoints", seams.name(i).c_str(), seams.waypointCount(i));
+  RCLCPP_INFO(LOGGER,
+              "Median of %" PRId64 " runs: preprocessing %.2f ms, segmentation %.2f ms, "
+              "extraction %.2f ms, time to seam %.2f ms",
+              repetitions, median(preprocessing_ms), median(segmentation_ms),
+              median(extraction_ms), median(total_ms));
+
+  rclcpp::shutdown();
+  return 0;
+}
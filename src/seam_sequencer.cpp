@@ -0,0 +1,241 @@
+#include <welding_demo/seam_sequencer.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <thread>
+
+namespace welding_demo
+{
+namespace
+{
+constexpr double IMPROVEMENT_EPSILON = 1e-9;
+constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+constexpr std::size_t MAX_SEGMENT_LENGTH = 3;
+}  // namespace
+
+double estimateTransitTime(const Eigen::VectorXd& from, const Eigen::VectorXd& to,
+                           const Eigen::VectorXd& max_velocity)
+{
+  return ((to - from).cwiseAbs().array() / max_velocity.array()).maxCoeff();
+}
+
+Eigen::MatrixXd transitCostMatrix(const std::vector<Eigen::VectorXd>& configurations,
+                                  const Eigen::VectorXd& max_velocity)
+{
+  const auto n = static_cast<Eigen::Index>(configurations.size());
+  Eigen::MatrixXd costs = Eigen::MatrixXd::Zero(n, n);
+  for (Eigen::Index i = 0; i < n; ++i)
+    for (Eigen::Index j = i + 1; j < n; ++j)
+      costs(i, j) = costs(j, i) =
+          estimateTransitTime(configurations[static_cast<std::size_t>(i)],
+                              configurations[static_cast<std::size_t>(j)], max_velocity);
+  return costs;
+}
+
+SeamSequencer::SeamSequencer(Eigen::MatrixXd transit)
+  : transit_(std::move(transit))
+  , seam_count_(static_cast<std::size_t>(transit_.rows() - 1) / 2)
+  , home_(2 * seam_count_)
+{
+}
+
+double SeamSequencer::cost(const std::vector<SequencedSeam>& sequence, bool return_home) const
+{
+  double total = 0.0;
+  std::size_t from = home_;
+  for (const SequencedSeam& s : sequence)
+  {
+    total += transit_(from, entry(s));
+    from = exit(s);
+  }
+  if (return_home)
+    total += transit_(from, home_);
+  return total;
+}
+
+std::vector<SequencedSeam> SeamSequencer::nearestNeighbour(std::size_t first, bool reversed) const
+{
+  std::vector<SequencedSeam> tour;
+  tour.reserve(seam_count_);
+  std::vector<bool> visited(seam_count_, false);
+  tour.push_back({ first, reversed });
+  visited[first] = true;
+  while (tour.size() < seam_count_)
+  {
+    const std::size_t from = exit(tour.back());
+    SequencedSeam best{ NONE, false };
+    double best_cost = std::numeric_limits<double>::infinity();
+    for (std::size_t s = 0; s < seam_count_; ++s)
+    {
+      if (visited[s])
+        continue;
+      for (bool r : { false, true })
+      {
+        const double c = transit_(from, entry({ s, r }));
+        if (c < best_cost)
+        {
+          best_cost = c;
+          best = { s, r };
+        }
+      }
+    }
+    visited[best.seam] = true;
+    tour.push_back(best);
+  }
+  return tour;
+}
+
+bool SeamSequencer::twoOpt(std::vector<SequencedSeam>& tour, bool return_home) const
+{
+  // Reversing the sub-sequence [i, j] also flips the welding direction of every seam in it, which
+  // keeps all inner transitions unchanged because the transit costs are symmetric.
+  const std::size_t n = tour.size();
+  bool improved = false;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const std::size_t prev = i == 0 ? home_ : exit(tour[i - 1]);
+    for (std::size_t j = i; j < n; ++j)
+    {
+      const std::size_t next = j + 1 < n ? entry(tour[j + 1]) : (return_home ? home_ : NONE);
+      const double old_cost = transit_(prev, entry(tour[i])) +
+                              (next == NONE ? 0.0 : transit_(exit(tour[j]), next));
+      const double new_cost = transit_(prev, exit(tour[j])) +
+                              (next == NONE ? 0.0 : transit_(entry(tour[i]), next));
+      if (new_cost + IMPROVEMENT_EPSILON < old_cost)
+      {
+        std::reverse(tour.begin() + static_cast<std::ptrdiff_t>(i),
+                     tour.begin() + static_cast<std::ptrdiff_t>(j + 1));
+        for (std::size_t k = i; k <= j; ++k)
+          tour[k].reversed = !tour[k].reversed;
+        improved = true;
+      }
+    }
+  }
+  return improved;
+}
+
+bool SeamSequencer::orOpt(std::vector<SequencedSeam>& tour, bool return_home) const
+{
+  // Move a segment of up to MAX_SEGMENT_LENGTH seams to another position, optionally reversed
+  const std::size_t n = tour.size();
+  bool improved = false;
+  std::vector<SequencedSeam> rest;
+  rest.reserve(n);
+  for (std::size_t len = 1; len <= std::min(MAX_SEGMENT_LENGTH, n); ++len)
+  {
+    for (std::size_t i = 0; i + len <= n; ++i)
+    {
+      const std::size_t prev = i == 0 ? home_ : exit(tour[i - 1]);
+      const std::size_t next = i + len < n ? entry(tour[i + len]) : (return_home ? home_ : NONE);
+      const double removal_gain =
+          transit_(prev, entry(tour[i])) +
+          (next == NONE ? 0.0 : transit_(exit(tour[i + len - 1]), next)) -
+          (next == NONE ? 0.0 : transit_(prev, next));
+
+      rest.assign(tour.begin(), tour.begin() + static_cast<std::ptrdiff_t>(i));
+      rest.insert(rest.end(), tour.begin() + static_cast<std::ptrdiff_t>(i + len), tour.end());
+
+      double best_delta = -IMPROVEMENT_EPSILON;
+      std::size_t best_pos = NONE;
+      bool best_flip = false;
+      for (std::size_t k = 0; k <= rest.size(); ++k)
+      {
+        const std::size_t a = k == 0 ? home_ : exit(rest[k - 1]);
+        const std::size_t b = k < rest.size() ? entry(rest[k]) : (return_home ? home_ : NONE);
+        for (bool flip : { false, true })
+        {
+          if (k == i && !flip)
+            continue;  // original position
+          const std::size_t seg_entry = flip ? exit(tour[i + len - 1]) : entry(tour[i]);
+          const std::size_t seg_exit = flip ? entry(tour[i]) : exit(tour[i + len - 1]);
+          const double insertion = transit_(a, seg_entry) +
+                                   (b == NONE ? 0.0 : transit_(seg_exit, b) - transit_(a, b));
+          const double delta = insertion - removal_gain;
+          if (delta < best_delta)
+          {
+            best_delta = delta;
+            best_pos = k;
+            best_flip = flip;
+          }
+        }
+      }
+      if (best_pos == NONE)
+        continue;
+
+      std::vector<SequencedSeam> segment(tour.begin() + static_cast<std::ptrdiff_t>(i),
+                                         tour.begin() + static_cast<std::ptrdiff_t>(i + len));
+      if (best_flip)
+      {
+        std::reverse(segment.begin(), segment.end());
+        for (SequencedSeam& s : segment)
+          s.reversed = !s.reversed;
+      }
+      rest.insert(rest.begin() + static_cast<std::ptrdiff_t>(best_pos), segment.begin(),
+                  segment.end());
+      tour.swap(rest);
+      improved = true;
+    }
+  }
+  return improved;
+}
+
+std::vector<SequencedSeam> SeamSequencer::solve(const Options& options, double* total_cost) const
+{
+  if (seam_count_ == 0)
+  {
+    if (total_cost)
+      *total_cost = 0.0;
+    return {};
+  }
+
+  // The first restart is the deterministic nearest neighbour tour from the cheapest first seam;
+  // the others start from random seams and directions.
+  const std::size_t restarts = std::max<std::size_t>(1, options.restarts);
+  std::vector<std::vector<SequencedSeam>> tours(restarts);
+  std::vector<double> costs(restarts, std::numeric_limits<double>::infinity());
+
+  auto run = [&](std::size_t r) {
+    std::size_t first = 0;
+    bool reversed = false;
+    if (r == 0)
+    {
+      Eigen::Index best;
+      transit_.row(static_cast<Eigen::Index>(home_)).head(2 * seam_count_).minCoeff(&best);
+      first = static_cast<std::size_t>(best) / 2;
+      reversed = (best % 2) == 1;
+    }
+    else
+    {
+      std::mt19937 rng(static_cast<unsigned>(r));
+      first = std::uniform_int_distribution<std::size_t>(0, seam_count_ - 1)(rng);
+      reversed = std::bernoulli_distribution(0.5)(rng);
+    }
+    std::vector<SequencedSeam> tour = nearestNeighbour(first, reversed);
+    while (twoOpt(tour, options.return_home) || orOpt(tour, options.return_home))
+    {
+    }
+    costs[r] = cost(tour, options.return_home);
+    tours[r] = std::move(tour);
+  };
+
+  const std::size_t threads =
+      std::min(restarts, options.threads ? options.threads :
+                                           std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < threads; ++t)
+    workers.emplace_back([&, t]() {
+      for (std::size_t r = t; r < restarts; r += threads)
+        run(r);
+    });
+  for (auto& worker : workers)
+    worker.join();
+
+  const auto best = static_cast<std::size_t>(
+      std::distance(costs.begin(), std::min_element(costs.begin(), costs.end())));
+  if (total_cost)
+    *total_cost = costs[best];
+  return tours[best];
+}
+}  // namespace welding_demo
@@ -0,0 +1,244 @@
+#include <welding_demo/seam_spline.hpp>
+#include <welding_demo/seam.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace welding_demo
+{
+namespace
+{
+// 5-point Gauss-Legendre quadrature on [0, 1]
+constexpr double GAUSS_NODES[5] = { 0.0469100770306680, 0.2307653449471585, 0.5,
+                                    0.7692346550528415, 0.9530899229693320 };
+constexpr double GAUSS_WEIGHTS[5] = { 0.1184634425280945, 0.2393143352496832, 0.2844444444444444,
+                                      0.2393143352496832, 0.1184634425280945 };
+
+// Logarithm and exponential of unit quaternions, as rotation vectors halved
+Eigen::Vector3d logarithm(const Eigen::Quaterniond& q)
+{
+  const double sin_norm = q.vec().norm();
+  if (sin_norm < 1e-12)
+    return Eigen::Vector3d::Zero();
+  return q.vec() * (std::atan2(sin_norm, q.w()) / sin_norm);
+}
+
+Eigen::Quaterniond exponential(const Eigen::Vector3d& v)
+{
+  const double angle = v.norm();
+  if (angle < 1e-12)
+    return Eigen::Quaterniond::Identity();
+  const Eigen::Vector3d axis = v * (std::sin(angle) / angle);
+  return Eigen::Quaterniond(std::cos(angle), axis.x(), axis.y(), axis.z());
+}
+
+Eigen::Quaterniond squadControl(const Eigen::Quaterniond& previous, const Eigen::Quaterniond& q,
+                                const Eigen::Quaterniond& next)
+{
+  // Relative rotations the short way round, the neighbours of the closing point of a closed
+  // spline may lie in the other hemisphere
+  auto relative = [&q](const Eigen::Quaterniond& other) {
+    Eigen::Quaterniond r = q.conjugate() * other;
+    if (r.w() < 0.0)
+      r.coeffs() = -r.coeffs();
+    return r;
+  };
+  return q * exponential(-0.25 * (logarithm(relative(next)) + logarithm(relative(previous))));
+}
+}  // namespace
+
+SeamSpline::SeamSpline(const std::vector<geometry_msgs::msg::Pose>& waypoints, bool closed)
+{
+  for (const auto& pose : waypoints)
+  {
+    const Eigen::Vector3d p(pose.position.x, pose.position.y, pose.position.z);
+    Eigen::Quaterniond q(pose.orientation.w, pose.orientation.x, pose.orientation.y,
+                         pose.orientation.z);
+    q.normalize();
+    if (!points_.empty() && (p - points_.back()).norm() < 1e-9)
+      continue;  // repeated waypoint, it would give a zero-length segment
+    // Keep consecutive quaternions in one hemisphere, so interpolation takes the short way
+    if (!orientations_.empty() && orientations_.back().dot(q) < 0.0)
+      q.coeffs() = -q.coeffs();
+    points_.push_back(p);
+    orientations_.push_back(q);
+  }
+  closed = closed && points_.size() > 2;
+  if (closed && (points_.back() - points_.front()).norm() > 1e-9)
+  {
+    points_.push_back(points_.front());
+    orientations_.push_back(orientations_.front());
+    if (orientations_[orientations_.size() - 2].dot(orientations_.back()) < 0.0)
+      orientations_.back().coeffs() = -orientations_.back().coeffs();
+  }
+  const std::size_t n = points_.size();
+  if (n < 2)
+    return;
+
+  // Tangents of the parabola through every point and its neighbours, per unit chord length. The
+  // ends of an open spline use the parabola through the first (last) three points.
+  std::vector<double> chord(n - 1);
+  std::vector<Eigen::Vector3d> slope(n - 1);
+  for (std::size_t i = 0; i + 1 < n; ++i)
+  {
+    chord[i] = (points_[i + 1] - points_[i]).norm();
+    slope[i] = (points_[i + 1] - points_[i]) / chord[i];
+  }
+  auto blend = [&](std::size_t before, std::size_t after) {
+    return (chord[before] * slope[after] + chord[after] * slope[before]) /
+           (chord[before] + chord[after]);
+  };
+  tangents_.resize(n);
+  for (std::size_t i = 1; i + 1 < n; ++i)
+    tangents_[i] = blend(i - 1, i);
+  if (closed)
+    tangents_[0] = tangents_[n - 1] = blend(n - 2, 0);
+  else if (n == 2)
+    tangents_[0] = tangents_[1] = slope[0];
+  else
+  {
+    tangents_[0] = 2.0 * slope[0] - tangents_[1];
+    tangents_[n - 1] = 2.0 * slope[n - 2] - tangents_[n - 2];
+  }
+
+  controls_.resize(n);
+  for (std::size_t i = 1; i + 1 < n; ++i)
+    controls_[i] = squadControl(orientations_[i - 1], orientations_[i], orientations_[i + 1]);
+  if (closed)
+  {
+    controls_[0] = squadControl(orientations_[n - 2], orientations_[0], orientations_[1]);
+    controls_[n - 1] = squadControl(orientations_[n - 2], orientations_[n - 1], orientations_[1]);
+  }
+  else
+  {
+    controls_[0] = orientations_[0];
+    controls_[n - 1] = orientations_[n - 1];
+  }
+
+  lengths_.assign(n, 0.0);
+  for (std::size_t i = 0; i + 1 < n; ++i)
+    lengths_[i + 1] = lengths_[i] + segmentLength(i, 1.0);
+}
+
+Eigen::Vector3d SeamSpline::derivative(std::size_t segment, double u) const
+{
+  const double h = (points_[segment + 1] - points_[segment]).norm();
+  // Derivatives of the cubic Hermite basis functions
+  const double d00 = 6.0 * u * u - 6.0 * u, d10 = 3.0 * u * u - 4.0 * u + 1.0;
+  const double d01 = -d00, d11 = 3.0 * u * u - 2.0 * u;
+  return d00 * points_[segment] + d10 * h * tangents_[segment] + d01 * points_[segment + 1] +
+         d11 * h * tangents_[segment + 1];
+}
+
+double SeamSpline::speed(std::size_t segment, double u) const
+{
+  return derivative(segment, u).norm();
+}
+
+double SeamSpline::segmentLength(std::size_t segment, double u) const
+{
+  double length = 0.0;
+  for (int k = 0; k < 5; ++k)
+    length += GAUSS_WEIGHTS[k] * speed(segment, u * GAUSS_NODES[k]);
+  return length * u;
+}
+
+void SeamSpline::locate(double s, std::size_t& segment, double& u) const
+{
+  s = std::clamp(s, 0.0, length());
+  segment = static_cast<std::size_t>(std::upper_bound(lengths_.begin(), lengths_.end(), s) -
+                                     lengths_.begin());
+  segment = std::min(segment == 0 ? 0 : segment - 1, points_.size() - 2);
+  const double target = s - lengths_[segment];
+  const double total = lengths_[segment + 1] - lengths_[segment];
+  u = total > 0.0 ? target / total : 0.0;
+  // Newton steps on the segment length, the chord length start is already close
+  for (int iteration = 0; iteration < 4; ++iteration)
+  {
+    const double v = speed(segment, u);
+    if (v < 1e-12)
+      break;
+    u = std::clamp(u - (segmentLength(segment, u) - target) / v, 0.0, 1.0);
+  }
+}
+
+Eigen::Vector3d SeamSpline::position(double s) const
+{
+  if (empty())
+    return points_.empty() ? Eigen::Vector3d::Zero() : points_.front();
+  std::size_t i;
+  double u;
+  locate(s, i, u);
+  const double h = (points_[i + 1] - points_[i]).norm();
+  const double u2 = u * u, u3 = u2 * u;
+  return (2.0 * u3 - 3.0 * u2 + 1.0) * points_[i] + (u3 - 2.0 * u2 + u) * h * tangents_[i] +
+         (-2.0 * u3 + 3.0 * u2) * points_[i + 1] + (u3 - u2) * h * tangents_[i + 1];
+}
+
+Eigen::Vector3d SeamSpline::tangent(double s) const
+{
+  if (empty())
+    return Eigen::Vector3d::UnitX();
+  std::size_t i;
+  double u;
+  locate(s, i, u);
+  return derivative(i, u).normalized();
+}
+
+Eigen::Quaterniond SeamSpline::orientation(double s) const
+{
+  if (empty())
+    return orientations_.empty() ? Eigen::Quaterniond::Identity() : orientations_.front();
+  std::size_t i;
+  double u;
+  locate(s, i, u);
+  const Eigen::Quaterniond outer = orientations_[i].slerp(u, orientations_[i + 1]);
+  const Eigen::Quaterniond inner = controls_[i].slerp(u, controls_[i + 1]);
+  return outer.slerp(2.0 * u * (1.0 - u), inner).normalized();
+}
+
+Eigen::Vector3d SeamSpline::normal(double s) const
+{
+  return seamNormal(orientation(s));
+}
+
+geometry_msgs::msg::Pose SeamSpline::pose(double s) const
+{
+  const Eigen::Vector3d p = position(s);
+  const Eigen::Quaterniond q = orientation(s);
+  geometry_msgs::msg::Pose pose;
+  pose.position.x = p.x();
+  pose.position.y = p.y();
+  pose.position.z = p.z();
+  pose.orientation.x = q.x();
+  pose.orientation.y = q.y();
+  pose.orientation.z = q.z();
+  pose.orientation.w = q.w();
+  return pose;
+}
+
+std::vector<geometry_msgs::msg::Pose> SeamSpline::sample(double step) const
+{
+  std::vector<geometry_msgs::msg::Pose> poses;
+  if (empty() || step <= 0.0)
+    return poses;
+  const auto count = static_cast<std::size_t>(std::ceil(length() / step)) + 1;
+  poses.reserve(count);
+  for (std::size_t k = 0; k < count; ++k)
+    poses.push_back(pose(length() * static_cast<double>(k) / static_cast<double>(count - 1)));
+  return poses;
+}
+
+std::vector<geometry_msgs::msg::Pose> SeamSpline::sample(const ClosedSeamSampling& sampling) const
+{
+  std::vector<geometry_msgs::msg::Pose> poses;
+  if (empty())
+    return poses;
+  const std::vector<double> positions = closedSeamPositions(length(), sampling);
+  poses.reserve(positions.size());
+  // Past the end the overlap continues on the first lap
+  for (double s : positions)
+    poses.push_back(pose(s > length() ? s - length() : s));
+  return poses;
+}
+}  // namespace welding_demo
@@ -0,0 +1,41 @@
+#include <welding_demo/startup_profiler.hpp>
+
+#include <rclcpp/logging.hpp>
+
+namespace welding_demo
+{
+StartupProfiler::StartupProfiler() : start_(Clock::now()), phase_start_(start_), end_(start_)
+{
+}
+
+void StartupProfiler::phase(const std::string& name)
+{
+  finish();
+  current_ = name;
+}
+
+void StartupProfiler::finish()
+{
+  const Clock::time_point now = Clock::now();
+  if (!current_.empty())
+    phases_.emplace_back(current_,
+                         std::chrono::duration<double, std::milli>(now - phase_start_).count());
+  current_.clear();
+  phase_start_ = now;
+  end_ = now;
+}
+
+double StartupProfiler::totalMs() const
+{
+  return std::chrono::duration<double, std::milli>(end_ - start_).count();
+}
+
+void StartupProfiler::report(const rclcpp::Logger& logger, bool detailed) const
+{
+  RCLCPP_INFO(logger, "Ready to plan %.0f ms after start", totalMs());
+  if (!detailed)
+    return;
+  for (const auto& phase : phases_)
+    RCLCPP_INFO(logger, "  %-28s %8.1f ms", phase.first.c_str(), phase.second);
+}
+}  // namespace welding_demo
@@ -0,0 +1,222 @@
+#include <welding_demo/trajectory_compression.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <welding_demo/trajectory_time.hpp>
+
+namespace welding_demo
+{
+namespace
+{
+// True when every sample strictly between the knots ``first`` and ``last`` is reproduced within
+// the tolerance
+bool segmentFits(const Eigen::VectorXd& times, const Eigen::MatrixXd& positions,
+                 const Eigen::MatrixXd& velocities, std::size_t first, std::size_t last,
+                 double tolerance)
+{
+  const auto i0 = static_cast<Eigen::Index>(first);
+  const auto i1 = static_cast<Eigen::Index>(last);
+  Eigen::VectorXd q(positions.cols());
+  for (Eigen::Index k = i0 + 1; k < i1; ++k)
+  {
+    hermite(times[i0], positions.row(i0).transpose(), velocities.row(i0).transpose(), times[i1],
+            positions.row(i1).transpose(), velocities.row(i1).transpose(), times[k], q);
+    if ((q - positions.row(k).transpose()).cwiseAbs().maxCoeff() > tolerance)
+      return false;
+  }
+  return true;
+}
+
+void toMatrices(const trajectory_msgs::msg::JointTrajectory& trajectory, Eigen::VectorXd& times,
+                Eigen::MatrixXd& positions, Eigen::MatrixXd& velocities)
+{
+  const auto n = static_cast<Eigen::Index>(trajectory.points.size());
+  const auto dof = static_cast<Eigen::Index>(trajectory.joint_names.size());
+  times.resize(n);
+  positions.resize(n, dof);
+  velocities.resize(n, dof);
+  bool have_velocities = true;
+  for (Eigen::Index i = 0; i < n; ++i)
+  {
+    const auto& point = trajectory.points[static_cast<std::size_t>(i)];
+    times[i] = toSec(point.time_from_start);
+    positions.row(i) = Eigen::Map<const Eigen::RowVectorXd>(point.positions.data(), dof);
+    if (point.velocities.size() == static_cast<std::size_t>(dof))
+      velocities.row(i) = Eigen::Map<const Eigen::RowVectorXd>(point.velocities.data(), dof);
+    else
+      have_velocities = false;
+  }
+  if (!have_velocities)
+    velocities = estimateVelocities(times, positions);
+}
+}  // namespace
+
+void hermite(double t0, const Eigen::Ref<const Eigen::VectorXd>& q0,
+             const Eigen::Ref<const Eigen::VectorXd>& v0, double t1,
+             const Eigen::Ref<const Eigen::VectorXd>& q1,
+             const Eigen::Ref<const Eigen::VectorXd>& v1, double t, Eigen::Ref<Eigen::VectorXd> q,
+             Eigen::VectorXd* v, Eigen::VectorXd* a)
+{
+  const double h = t1 - t0;
+  if (h <= 0.0)
+  {
+    q = q1;
+    if (v)
+      *v = v1;
+    if (a)
+      a->setZero(q0.size());
+    return;
+  }
+  const double s = (t - t0) / h;
+  const double s2 = s * s;
+  const double s3 = s2 * s;
+  const double h00 = 2 * s3 - 3 * s2 + 1;
+  const double h10 = s3 - 2 * s2 + s;
+  const double h01 = -2 * s3 + 3 * s2;
+  const double h11 = s3 - s2;
+  q = h00 * q0 + h10 * h * v0 + h01 * q1 + h11 * h * v1;
+  if (v)
+  {
+    const double d00 = (6 * s2 - 6 * s) / h;
+    const double d10 = 3 * s2 - 4 * s + 1;
+    const double d01 = (-6 * s2 + 6 * s) / h;
+    const double d11 = 3 * s2 - 2 * s;
+    *v = d00 * q0 + d10 * v0 + d01 * q1 + d11 * v1;
+  }
+  if (a)
+  {
+    const double dd00 = (12 * s - 6) / (h * h);
+    const double dd10 = (6 * s - 4) / h;
+    const double dd01 = (-12 * s + 6) / (h * h);
+    const double dd11 = (6 * s - 2) / h;
+    *a = dd00 * q0 + dd10 * v0 + dd01 * q1 + dd11 * v1;
+  }
+}
+
+Eigen::MatrixXd estimateVelocities(const Eigen::VectorXd& times, const Eigen::MatrixXd& positions)
+{
+  const Eigen::Index n = positions.rows();
+  Eigen::MatrixXd velocities = Eigen::MatrixXd::Zero(n, positions.cols());
+  for (Eigen::Index i = 1; i + 1 < n; ++i)
+  {
+    const double dt = times[i + 1] - times[i - 1];
+    if (dt > 0.0)
+      velocities.row(i) = (positions.row(i + 1) - positions.row(i - 1)) / dt;
+  }
+  return velocities;
+}
+
+std::vector<std::size_t> selectKnots(const Eigen::VectorXd& times,
+                                     const Eigen::MatrixXd& positions,
+                                     const Eigen::MatrixXd& velocities, double tolerance)
+{
+  const auto n = static_cast<std::size_t>(positions.rows());
+  std::vector<std::size_t> knots;
+  if (n == 0)
+    return knots;
+  knots.push_back(0);
+  std::size_t start = 0;
+  while (start + 1 < n)
+  {
+    // Grow the segment exponentially until it stops fitting, then bisect the last step
+    std::size_t good = start + 1;
+    std::size_t step = 1;
+    std::size_t bad = n;
+    while (good + step < n)
+    {
+      if (!segmentFits(times, positions, velocities, start, good + step, tolerance))
+      {
+        bad = good + step;
+        break;
+      }
+      good += step;
+      step *= 2;
+    }
+    if (bad == n && good + 1 < n)
+    {
+      if (segmentFits(times, positions, velocities, start, n - 1, tolerance))
+        good = n - 1;
+      else
+        bad = n - 1;
+    }
+    while (bad - good > 1 && bad != n)
+    {
+      const std::size_t mid = good + (bad - good) / 2;
+      if (segmentFits(times, positions, velocities, start, mid, tolerance))
+        good = mid;
+      else
+        bad = mid;
+    }
+    knots.push_back(good);
+    start = good;
+  }
+  return knots;
+}
+
+void compressTrajectory(const trajectory_msgs::msg::JointTrajectory& in,
+                        trajectory_msgs::msg::JointTrajectory& out, double tolerance)
+{
+  Eigen::VectorXd times;
+  Eigen::MatrixXd positions, velocities;
+  toMatrices(in, times, positions, velocities);
+  const std::vector<std::size_t> knots = selectKnots(times, positions, velocities, tolerance);
+
+  out.header = in.header;
+  out.joint_names = in.joint_names;
+  out.points.resize(knots.size());
+  for (std::size_t i = 0; i < knots.size(); ++i)
+  {
+    const Eigen::RowVectorXd velocity = velocities.row(static_cast<Eigen::Index>(knots[i]));
+    auto& point = out.points[i];
+    point.positions = in.points[knots[i]].positions;
+    point.velocities.assign(velocity.data(), velocity.data() + velocity.size());
+    point.accelerations.clear();
+    point.effort.clear();
+    point.time_from_start = in.points[knots[i]].time_from_start;
+  }
+}
+
+void decompressTrajectory(const trajectory_msgs::msg::JointTrajectory& in,
+                          trajectory_msgs::msg::JointTrajectory& out, double period)
+{
+  Eigen::VectorXd times;
+  Eigen::MatrixXd positions, velocities;
+  toMatrices(in, times, positions, velocities);
+
+  out.header = in.header;
+  out.joint_names = in.joint_names;
+  out.points.clear();
+  const Eigen::Index n = times.size();
+  if (n == 0)
+    return;
+  // Samples every ``period`` and the end point. A regular sample closer to the end than a small
+  // fraction of the period is left out: rounded to nanoseconds, its interval to the end would be
+  // zero or a few nanoseconds, which blows up the velocities estimated from it.
+  const double duration = times[n - 1] - times[0];
+  const double min_interval = 1e-3 * period;
+  std::size_t samples = 1;
+  if (duration > 0.0)
+    samples += static_cast<std::size_t>(
+        std::max(1.0, std::ceil((duration - min_interval) / period)));
+  out.points.resize(samples);
+
+  Eigen::VectorXd q(positions.cols()), v, a;
+  Eigen::Index segment = 0;
+  for (std::size_t i = 0; i < samples; ++i)
+  {
+    const double t = i + 1 < samples ? times[0] + static_cast<double>(i) * period : times[n - 1];
+    while (segment + 2 < n && times[segment + 1] < t)
+      ++segment;
+    const Eigen::Index next = std::min(segment + 1, n - 1);
+    hermite(times[segment], positions.row(segment).transpose(),
+            velocities.row(segment).transpose(), times[next], positions.row(next).transpose(),
+            velocities.row(next).transpose(), t, q, &v, &a);
+    auto& point = out.points[i];
+    point.positions.assign(q.data(), q.data() + q.size());
+    point.velocities.assign(v.data(), v.data() + v.size());
+    point.accelerations.assign(a.data(), a.data() + a.size());
+    point.time_from_start = fromSec(t);
+  }
+}
+}  // namespace welding_demo
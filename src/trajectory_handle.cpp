@@ -0,0 +1,58 @@
+#include <welding_demo/trajectory_handle.hpp>
+
+#include <atomic>
+
+namespace welding_demo
+{
+namespace
+{
+std::atomic<std::size_t> copied_points{ 0 };
+}  // namespace
+
+TrajectoryHandle::TrajectoryHandle()
+  : trajectory_(std::make_shared<moveit_msgs::msg::RobotTrajectory>())
+{
+}
+
+TrajectoryHandle::TrajectoryHandle(moveit_msgs::msg::RobotTrajectory&& trajectory)
+  : trajectory_(std::make_shared<moveit_msgs::msg::RobotTrajectory>(std::move(trajectory)))
+{
+}
+
+moveit_msgs::msg::RobotTrajectory& TrajectoryHandle::edit()
+{
+  unshare();
+  return *trajectory_;
+}
+
+moveit_msgs::msg::RobotTrajectory TrajectoryHandle::release()
+{
+  unshare();
+  moveit_msgs::msg::RobotTrajectory trajectory = std::move(*trajectory_);
+  trajectory_ = std::make_shared<moveit_msgs::msg::RobotTrajectory>();
+  return trajectory;
+}
+
+std::size_t TrajectoryHandle::copiedPoints()
+{
+  return copied_points.load(std::memory_order_relaxed);
+}
+
+void TrajectoryHandle::countCopy(const moveit_msgs::msg::RobotTrajectory& trajectory)
+{
+  copied_points.fetch_add(trajectory.joint_trajectory.points.size() +
+                              trajectory.multi_dof_joint_trajectory.points.size(),
+                          std::memory_order_relaxed);
+}
+
+void TrajectoryHandle::unshare()
+{
+  if (!trajectory_)  // moved from
+    trajectory_ = std::make_shared<moveit_msgs::msg::RobotTrajectory>();
+  else if (trajectory_.use_count() > 1)
+  {
+    countCopy(*trajectory_);
+    trajectory_ = std::make_shared<moveit_msgs::msg::RobotTrajectory>(*trajectory_);
+  }
+}
+}  // namespace welding_demo
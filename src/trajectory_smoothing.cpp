@@ -0,0 +1,123 @@
+#include <welding_demo/trajectory_smoothing.hpp>
+#include <welding_demo/trajectory_compression.hpp>
+#include <welding_demo/trajectory_time.hpp>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+#include <cmath>
+
+namespace welding_demo
+{
+namespace
+{
+constexpr int MAX_SCALE_BACK_STEPS = 4;
+}  // namespace
+
+Eigen::VectorXd savitzkyGolayCoefficients(int half_window, int order)
+{
+  const int size = 2 * half_window + 1;
+  Eigen::MatrixXd vandermonde(size, order + 1);
+  for (int i = 0; i < size; ++i)
+    for (int j = 0; j <= order; ++j)
+      vandermonde(i, j) = std::pow(static_cast<double>(i - half_window), j);
+  // The smoothed value at the window center is the constant term of the least-squares fit
+  const Eigen::MatrixXd pseudo_inverse =
+      (vandermonde.transpose() * vandermonde).ldlt().solve(vandermonde.transpose());
+  return pseudo_inverse.row(0).transpose();
+}
+
+Eigen::MatrixXd filterRows(const Eigen::MatrixXd& positions, const Eigen::VectorXd& coefficients)
+{
+  const Eigen::Index half_window = coefficients.size() / 2;
+  const Eigen::Index n = positions.rows();
+  Eigen::MatrixXd filtered = positions;
+  if (n < coefficients.size())
+    return filtered;
+  const Eigen::Index inner = n - 2 * half_window;
+  auto center = filtered.middleRows(half_window, inner);
+  center.setZero();
+  for (Eigen::Index k = 0; k < coefficients.size(); ++k)
+    center += coefficients[k] * positions.middleRows(k, inner);
+  return filtered;
+}
+
+SmoothingResult smoothTrajectory(moveit_msgs::msg::RobotTrajectory& trajectory,
+                                 moveit::core::RobotState& state,
+                                 const moveit::core::LinkModel* tip,
+                                 const SmoothingOptions& options)
+{
+  SmoothingResult result;
+  auto& jt = trajectory.joint_trajectory;
+  const auto n = static_cast<Eigen::Index>(jt.points.size());
+  const auto dof = static_cast<Eigen::Index>(jt.joint_names.size());
+  if (n < 2 * options.half_window + 1)
+    return result;
+
+  Eigen::MatrixXd positions(n, dof);
+  Eigen::VectorXd times(n);
+  for (Eigen::Index i = 0; i < n; ++i)
+  {
+    const auto& point = jt.points[static_cast<std::size_t>(i)];
+    positions.row(i) = Eigen::Map<const Eigen::RowVectorXd>(point.positions.data(), dof);
+    times[i] = toSec(point.time_from_start);
+  }
+  Eigen::MatrixXd smoothed =
+      filterRows(positions, savitzkyGolayCoefficients(options.half_window, options.order));
+
+  // Bound the tool deviation caused by the filter, in position and orientation
+  std::vector<double> joint_values(static_cast<std::size_t>(dof));
+  auto toolPose = [&](const Eigen::RowVectorXd& q) -> Eigen::Isometry3d {
+    Eigen::Map<Eigen::RowVectorXd>(joint_values.data(), dof) = q;
+    state.setVariablePositions(jt.joint_names, joint_values);
+    state.updateLinkTransforms();
+    return state.getGlobalLinkTransform(tip);
+  };
+  for (Eigen::Index i = options.half_window; i < n - options.half_window; ++i)
+  {
+    const Eigen::Isometry3d planned = toolPose(positions.row(i));
+    double deviation = 0.0;
+    double angle = 0.0;
+    auto measure = [&]() {
+      const Eigen::Isometry3d pose = toolPose(smoothed.row(i));
+      deviation = (pose.translation() - planned.translation()).norm();
+      angle = Eigen::AngleAxisd(planned.linear().transpose() * pose.linear()).angle();
+    };
+    auto exceeded = [&]() {
+      return deviation > options.max_tcp_deviation || angle > options.max_orientation_deviation;
+    };
+    measure();
+    int steps = 0;
+    while (exceeded() && steps < MAX_SCALE_BACK_STEPS)
+    {
+      smoothed.row(i) = 0.5 * (smoothed.row(i) + positions.row(i));
+      measure();
+      ++steps;
+    }
+    if (exceeded())
+    {
+      smoothed.row(i) = positions.row(i);
+      deviation = 0.0;
+      angle = 0.0;
+    }
+    if (steps > 0)
+      ++result.limited_points;
+    result.max_tcp_deviation = std::max(result.max_tcp_deviation, deviation);
+    result.max_orientation_deviation = std::max(result.max_orientation_deviation, angle);
+  }
+
+  const Eigen::MatrixXd velocities = estimateVelocities(times, smoothed);
+  const Eigen::MatrixXd accelerations = estimateVelocities(times, velocities);
+  for (Eigen::Index i = 0; i < n; ++i)
+  {
+    auto& point = jt.points[static_cast<std::size_t>(i)];
+    const Eigen::RowVectorXd q = smoothed.row(i);
+    const Eigen::RowVectorXd v = velocities.row(i);
+    const Eigen::RowVectorXd a = accelerations.row(i);
+    point.positions.assign(q.data(), q.data() + dof);
+    point.velocities.assign(v.data(), v.data() + dof);
+    point.accelerations.assign(a.data(), a.data() + dof);
+  }
+  return result;
+}
+}  // namespace welding_demo
@@ -0,0 +1,286 @@
+#include <welding_demo/transit_planner.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include <rclcpp/serialization.hpp>
+
+#include <welding_demo/seam.hpp>
+#include <welding_demo/trajectory_time.hpp>
+
+namespace welding_demo
+{
+namespace
+{
+template <typename T>
+void writePod(std::ostream& out, const T& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readPod(std::istream& in, T& value)
+{
+  return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+}  // namespace
+
+geometry_msgs::msg::Pose offsetAlongSeamNormal(const geometry_msgs::msg::Pose& pose,
+                                               double distance)
+{
+  const Eigen::Vector3d offset = distance * seamNormal(pose);
+  geometry_msgs::msg::Pose moved = pose;
+  moved.position.x += offset.x();
+  moved.position.y += offset.y();
+  moved.position.z += offset.z();
+  return moved;
+}
+
+void addApproachAndRetract(std::vector<geometry_msgs::msg::Pose>& waypoints,
+                           double approach_distance, double retract_distance)
+{
+  if (waypoints.empty())
+    return;
+  if (approach_distance > 0.0)
+    waypoints.insert(waypoints.begin(),
+                     offsetAlongSeamNormal(waypoints.front(), approach_distance));
+  if (retract_distance > 0.0)
+    waypoints.push_back(offsetAlongSeamNormal(waypoints.back(), retract_distance));
+}
+
+void reverseTrajectory(const moveit_msgs::msg::RobotTrajectory& in,
+                       moveit_msgs::msg::RobotTrajectory& out)
+{
+  const auto& points = in.joint_trajectory.points;
+  out.joint_trajectory.header = in.joint_trajectory.header;
+  out.joint_trajectory.joint_names = in.joint_trajectory.joint_names;
+  out.joint_trajectory.points.assign(points.rbegin(), points.rend());
+  if (points.empty())
+    return;
+  const double duration = toSec(points.back().time_from_start);
+  for (auto& point : out.joint_trajectory.points)
+  {
+    point.time_from_start = fromSec(duration - toSec(point.time_from_start));
+    for (double& v : point.velocities)
+      v = -v;
+  }
+}
+
+int TransitRoadmap::findNode(const std::vector<double>& positions) const
+{
+  for (std::size_t i = 0; i < nodes_.size(); ++i)
+  {
+    const std::vector<double>& node = nodes_[i];
+    if (node.size() != positions.size())
+      continue;
+    bool match = true;
+    for (std::size_t j = 0; j < node.size() && match; ++j)
+      match = std::fabs(node[j] - positions[j]) <= joint_tolerance_;
+    if (match)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+std::size_t TransitRoadmap::addNode(const std::vector<double>& positions)
+{
+  const int existing = findNode(positions);
+  if (existing >= 0)
+    return static_cast<std::size_t>(existing);
+  nodes_.push_back(positions);
+  return nodes_.size() - 1;
+}
+
+bool TransitRoadmap::lookup(const std::vector<double>& start, const std::vector<double>& goal,
+                            moveit_msgs::msg::RobotTrajectory& trajectory) const
+{
+  const int from = findNode(start);
+  const int to = findNode(goal);
+  if (from < 0 || to < 0)
+    return false;
+  const auto key = std::make_pair(static_cast<std::size_t>(from), static_cast<std::size_t>(to));
+  auto it = edges_.find(key);
+  if (it != edges_.end())
+  {
+    trajectory = it->second;
+    return true;
+  }
+  it = edges_.find(std::make_pair(key.second, key.first));
+  if (it != edges_.end())
+  {
+    reverseTrajectory(it->second, trajectory);
+    return true;
+  }
+  return false;
+}
+
+void TransitRoadmap::insert(const std::vector<double>& start, const std::vector<double>& goal,
+                            const moveit_msgs::msg::RobotTrajectory& trajectory)
+{
+  const std::size_t from = addNode(start);
+  const std::size_t to = addNode(goal);
+  edges_[std::make_pair(from, to)] = trajectory;
+}
+
+bool TransitRoadmap::insert(const moveit_msgs::msg::RobotTrajectory& trajectory,
+                            const std::vector<std::string>& joint_names)
+{
+  const auto& jt = trajectory.joint_trajectory;
+  if (jt.points.empty())
+    return false;
+  std::vector<std::size_t> order;
+  order.reserve(joint_names.size());
+  for (const auto& name : joint_names)
+  {
+    const auto it = std::find(jt.joint_names.begin(), jt.joint_names.end(), name);
+    if (it == jt.joint_names.end())
+      return false;
+    order.push_back(static_cast<std::size_t>(it - jt.joint_names.begin()));
+  }
+  auto reorder = [&order](const std::vector<double>& values) {
+    std::vector<double> reordered;
+    if (values.empty())
+      return reordered;
+    reordered.reserve(order.size());
+    for (std::size_t i : order)
+      reordered.push_back(i < values.size() ? values[i] : 0.0);
+    return reordered;
+  };
+
+  moveit_msgs::msg::RobotTrajectory reordered;
+  reordered.joint_trajectory.header = jt.header;
+  reordered.joint_trajectory.joint_names = joint_names;
+  reordered.joint_trajectory.points.resize(jt.points.size());
+  for (std::size_t i = 0; i < jt.points.size(); ++i)
+  {
+    auto& point = reordered.joint_trajectory.points[i];
+    point.positions = reorder(jt.points[i].positions);
+    point.velocities = reorder(jt.points[i].velocities);
+    point.accelerations = reorder(jt.points[i].accelerations);
+    point.effort = reorder(jt.points[i].effort);
+    point.time_from_start = jt.points[i].time_from_start;
+  }
+  const auto& points = reordered.joint_trajectory.points;
+  insert(points.front().positions, points.back().positions, reordered);
+  return true;
+}
+
+bool TransitRoadmap::save(const std::string& path) const
+{
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out)
+    return false;
+  writePod(out, static_cast<uint64_t>(nodes_.size()));
+  for (const auto& node : nodes_)
+  {
+    writePod(out, static_cast<uint64_t>(node.size()));
+    out.write(reinterpret_cast<const char*>(node.data()),
+              static_cast<std::streamsize>(node.size() * sizeof(double)));
+  }
+
+  rclcpp::Serialization<moveit_msgs::msg::RobotTrajectory> serialization;
+  writePod(out, static_cast<uint64_t>(edges_.size()));
+  for (const auto& edge : edges_)
+  {
+    rclcpp::SerializedMessage serialized;
+    serialization.serialize_message(&edge.second, &serialized);
+    const auto& raw = serialized.get_rcl_serialized_message();
+    writePod(out, static_cast<uint64_t>(edge.first.first));
+    writePod(out, static_cast<uint64_t>(edge.first.second));
+    writePod(out, static_cast<uint64_t>(raw.buffer_length));
+    out.write(reinterpret_cast<const char*>(raw.buffer),
+              static_cast<std::streamsize>(raw.buffer_length));
+  }
+  return static_cast<bool>(out);
+}
+
+bool TransitRoadmap::load(const std::string& path)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return false;
+
+  std::vector<std::vector<double>> nodes;
+  uint64_t count = 0;
+  if (!readPod(in, count))
+    return false;
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    uint64_t size = 0;
+    if (!readPod(in, size))
+      return false;
+    std::vector<double> node(size);
+    if (!in.read(reinterpret_cast<char*>(node.data()),
+                 static_cast<std::streamsize>(size * sizeof(double))))
+      return false;
+    nodes.push_back(std::move(node));
+  }
+
+  rclcpp::Serialization<moveit_msgs::msg::RobotTrajectory> serialization;
+  std::map<std::pair<std::size_t, std::size_t>, moveit_msgs::msg::RobotTrajectory> edges;
+  if (!readPod(in, count))
+    return false;
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    uint64_t from = 0, to = 0, length = 0;
+    if (!readPod(in, from) || !readPod(in, to) || !readPod(in, length) || from >= nodes.size() ||
+        to >= nodes.size())
+      return false;
+    rclcpp::SerializedMessage serialized(length);
+    auto& raw = serialized.get_rcl_serialized_message();
+    if (!in.read(reinterpret_cast<char*>(raw.buffer), static_cast<std::streamsize>(length)))
+      return false;
+    raw.buffer_length = length;
+    serialization.deserialize_message(&serialized, &edges[std::make_pair(from, to)]);
+  }
+
+  nodes_ = std::move(nodes);
+  edges_ = std::move(edges);
+  return true;
+}
+
+TransitPlanner::TransitPlanner(moveit::planning_interface::MoveGroupInterface& move_group,
+                               double joint_tolerance)
+  : move_group_(move_group), roadmap_(joint_tolerance)
+{
+}
+
+bool TransitPlanner::plan(const std::vector<double>& start, const std::vector<double>& goal,
+                          moveit_msgs::msg::RobotTrajectory& trajectory, bool* cache_hit)
+{
+  if (roadmap_.lookup(start, goal, trajectory))
+  {
+    // The cached plan may start and end up to the joint tolerance away from the requested start
+    // and goal. Both ends are pinned, the goal is where the following Cartesian plan starts.
+    auto& points = trajectory.joint_trajectory.points;
+    if (!points.empty())
+    {
+      points.front().positions = start;
+      points.back().positions = goal;
+    }
+    ++hits_;
+    if (cache_hit)
+      *cache_hit = true;
+    return true;
+  }
+  ++misses_;
+  if (cache_hit)
+    *cache_hit = false;
+
+  moveit::core::RobotState start_state(move_group_.getRobotModel());
+  start_state.setToDefaultValues();
+  start_state.setJointGroupPositions(move_group_.getName(), start);
+  move_group_.setStartState(start_state);
+  move_group_.setJointValueTarget(goal);
+  moveit::planning_interface::MoveGroupInterface::Plan plan;
+  const bool success = move_group_.plan(plan) == moveit::core::MoveItErrorCode::SUCCESS;
+  move_group_.setStartStateToCurrentState();
+  if (!success)
+    return false;
+
+  trajectory = plan.trajectory_;
+  roadmap_.insert(start, goal, trajectory);
+  return true;
+}
+}  // namespace welding_demo
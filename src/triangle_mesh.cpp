@@ -0,0 +1,467 @@
+#include <welding_demo/triangle_mesh.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+namespace welding_demo
+{
+namespace
+{
+bool endsWith(const std::string& s, const std::string& suffix)
+{
+  if (s.size() < suffix.size())
+    return false;
+  return std::equal(suffix.rbegin(), suffix.rend(), s.rbegin(),
+                    [](char a, char b) { return std::tolower(a) == std::tolower(b); });
+}
+
+bool loadStl(const std::string& path, TriangleMesh& mesh)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return false;
+  in.seekg(0, std::ios::end);
+  const auto size = static_cast<std::size_t>(in.tellg());
+  in.seekg(0);
+
+  // Binary files are recognized by their size, ASCII exports also start with "solid"
+  char header[80];
+  uint32_t count = 0;
+  if (size >= 84 && in.read(header, 80) && in.read(reinterpret_cast<char*>(&count), 4) &&
+      size == 84 + 50ull * count)
+  {
+    std::vector<char> data(50ull * count);
+    if (!in.read(data.data(), static_cast<std::streamsize>(data.size())))
+      return false;
+    mesh.vertices.reserve(3ull * count);
+    mesh.triangles.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      float v[9];
+      std::memcpy(v, data.data() + 50ull * i + 12, sizeof(v));  // after the facet normal
+      const int first = static_cast<int>(mesh.vertices.size());
+      for (int k = 0; k < 3; ++k)
+        mesh.vertices.emplace_back(v[3 * k], v[3 * k + 1], v[3 * k + 2]);
+      mesh.triangles.emplace_back(first, first + 1, first + 2);
+    }
+    return true;
+  }
+
+  in.clear();
+  in.seekg(0);
+  std::string keyword;
+  while (in >> keyword)
+    if (keyword == "vertex")
+    {
+      Eigen::Vector3f v;
+      if (!(in >> v.x() >> v.y() >> v.z()))
+        return false;
+      mesh.vertices.push_back(v);
+      if (mesh.vertices.size() % 3 == 0)
+      {
+        const int first = static_cast<int>(mesh.vertices.size()) - 3;
+        mesh.triangles.emplace_back(first, first + 1, first + 2);
+      }
+    }
+  return !mesh.triangles.empty();
+}
+
+bool loadObj(const std::string& path, TriangleMesh& mesh)
+{
+  std::ifstream in(path);
+  if (!in)
+    return false;
+  std::string line;
+  std::vector<int> face;
+  while (std::getline(in, line))
+  {
+    std::istringstream fields(line);
+    std::string keyword;
+    fields >> keyword;
+    if (keyword == "v")
+    {
+      Eigen::Vector3f v;
+      if (!(fields >> v.x() >> v.y() >> v.z()))
+        return false;
+      mesh.vertices.push_back(v);
+    }
+    else if (keyword == "f")
+    {
+      // "f 1 2 3", "f 1/1 2/2 3/3" or "f 1//1 ...", negative indices count from the end
+      face.clear();
+      std::string corner;
+      while (fields >> corner)
+      {
+        const int index = std::atoi(corner.c_str());
+        face.push_back(index < 0 ? static_cast<int>(mesh.vertices.size()) + index : index - 1);
+      }
+      for (std::size_t k = 2; k < face.size(); ++k)
+        mesh.triangles.emplace_back(face[0], face[k - 1], face[k]);
+    }
+  }
+  return true;
+}
+
+std::size_t plyTypeSize(const std::string& type)
+{
+  if (type == "char" || type == "uchar" || type == "int8" || type == "uint8")
+    return 1;
+  if (type == "short" || type == "ushort" || type == "int16" || type == "uint16")
+    return 2;
+  if (type == "int" || type == "uint" || type == "int32" || type == "uint32" ||
+      type == "float" || type == "float32")
+    return 4;
+  if (type == "double" || type == "float64")
+    return 8;
+  return 0;
+}
+
+bool readPlyScalar(std::istream& in, const std::string& type, bool binary, double& value)
+{
+  if (!binary)
+    return static_cast<bool>(in >> value);
+  unsigned char bytes[8];
+  const std::size_t size = plyTypeSize(type);
+  if (size == 0 || !in.read(reinterpret_cast<char*>(bytes), static_cast<std::streamsize>(size)))
+    return false;
+  const bool is_signed = type[0] != 'u';
+  const bool is_float = type.rfind("float", 0) == 0 || type == "double";
+  if (is_float && size == 4)
+  {
+    float f;
+    std::memcpy(&f, bytes, 4);
+    value = f;
+  }
+  else if (is_float)
+    std::memcpy(&value, bytes, 8);
+  else if (size == 1)
+    value = is_signed ? static_cast<int8_t>(bytes[0]) : bytes[0];
+  else if (size == 2)
+  {
+    uint16_t u;
+    std::memcpy(&u, bytes, 2);
+    value = is_signed ? static_cast<int16_t>(u) : u;
+  }
+  else
+  {
+    uint32_t u;
+    std::memcpy(&u, bytes, 4);
+    value = is_signed ? static_cast<int32_t>(u) : u;
+  }
+  return true;
+}
+
+// ASCII and binary little-endian PLY, the vertex and face elements are read
+bool loadPly(const std::string& path, TriangleMesh& mesh)
+{
+  struct Property
+  {
+    std::string name, type, count_type;  // count_type is set for lists
+  };
+  struct Element
+  {
+    std::string name;
+    std::size_t count = 0;
+    std::vector<Property> properties;
+  };
+
+  std::ifstream in(path, std::ios::binary);
+  std::string line;
+  if (!in || !std::getline(in, line) || line.rfind("ply", 0) != 0)
+    return false;
+  std::vector<Element> elements;
+  bool binary = false;
+  while (std::getline(in, line) && line.rfind("end_header", 0) != 0)
+  {
+    std::istringstream fields(line);
+    std::string keyword;
+    fields >> keyword;
+    if (keyword == "format")
+    {
+      std::string format;
+      fields >> format;
+      if (format != "ascii" && format != "binary_little_endian")
+        return false;
+      binary = format == "binary_little_endian";
+    }
+    else if (keyword == "element")
+    {
+      elements.emplace_back();
+      fields >> elements.back().name >> elements.back().count;
+    }
+    else if (keyword == "property" && !elements.empty())
+    {
+      Property property;
+      fields >> property.type;
+      if (property.type == "list")
+        fields >> property.count_type >> property.type;
+      fields >> property.name;
+      elements.back().properties.push_back(property);
+    }
+  }
+
+  double value;
+  for (const Element& element : elements)
+    for (std::size_t i = 0; i < element.count; ++i)
+    {
+      Eigen::Vector3f vertex = Eigen::Vector3f::Zero();
+      for (const Property& property : element.properties)
+      {
+        if (property.count_type.empty())
+        {
+          if (!readPlyScalar(in, property.type, binary, value))
+            return false;
+          if (element.name == "vertex" && property.name.size() == 1 &&
+              property.name[0] >= 'x' && property.name[0] <= 'z')
+            vertex[property.name[0] - 'x'] = static_cast<float>(value);
+          continue;
+        }
+        if (!readPlyScalar(in, property.count_type, binary, value))
+          return false;
+        std::vector<int> face(static_cast<std::size_t>(value));
+        for (int& index : face)
+        {
+          if (!readPlyScalar(in, property.type, binary, value))
+            return false;
+          index = static_cast<int>(value);
+        }
+        if (element.name == "face")
+          for (std::size_t k = 2; k < face.size(); ++k)
+            mesh.triangles.emplace_back(face[0], face[k - 1], face[k]);
+      }
+      if (element.name == "vertex")
+        mesh.vertices.push_back(vertex);
+    }
+  return true;
+}
+}  // namespace
+
+Eigen::Vector3f TriangleMesh::faceNormal(std::size_t triangle) const
+{
+  const Eigen::Vector3i& t = triangles[triangle];
+  return (vertices[t[1]] - vertices[t[0]]).cross(vertices[t[2]] - vertices[t[0]]).normalized();
+}
+
+bool loadMesh(const std::string& path, TriangleMesh& mesh, float scale)
+{
+  mesh = TriangleMesh();
+  bool loaded = false;
+  if (endsWith(path, ".stl"))
+    loaded = loadStl(path, mesh);
+  else if (endsWith(path, ".obj"))
+    loaded = loadObj(path, mesh);
+  else if (endsWith(path, ".ply"))
+    loaded = loadPly(path, mesh);
+  if (!loaded)
+    return false;
+
+  // Drop faces with out of range indices rather than reading past the vertices later
+  const int vertex_count = static_cast<int>(mesh.vertices.size());
+  mesh.triangles.erase(std::remove_if(mesh.triangles.begin(), mesh.triangles.end(),
+                                      [vertex_count](const Eigen::Vector3i& t) {
+                                        return t.minCoeff() < 0 || t.maxCoeff() >= vertex_count;
+                                      }),
+                       mesh.triangles.end());
+  for (Eigen::Vector3f& v : mesh.vertices)
+    v *= scale;
+  return !mesh.triangles.empty();
+}
+
+Eigen::Matrix3Xf sampleSurface(const TriangleMesh& mesh, std::size_t count)
+{
+  // Pick triangles in proportion to their area, then a uniform point inside the triangle
+  std::vector<double> cumulative_area(mesh.triangles.size());
+  double area = 0.0;
+  for (std::size_t i = 0; i < mesh.triangles.size(); ++i)
+  {
+    const Eigen::Vector3i& t = mesh.triangles[i];
+    area += 0.5 * (mesh.vertices[t[1]] - mesh.vertices[t[0]])
+                      .cross(mesh.vertices[t[2]] - mesh.vertices[t[0]])
+                      .norm();
+    cumulative_area[i] = area;
+  }
+  if (area <= 0.0)
+    return Eigen::Matrix3Xf();
+
+  Eigen::Matrix3Xf points(3, static_cast<Eigen::Index>(count));
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> pick(0.0, area);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  for (Eigen::Index i = 0; i < points.cols(); ++i)
+  {
+    const auto triangle = std::min<std::size_t>(
+        static_cast<std::size_t>(
+            std::lower_bound(cumulative_area.begin(), cumulative_area.end(), pick(rng)) -
+            cumulative_area.begin()),
+        mesh.triangles.size() - 1);
+    const Eigen::Vector3i& t = mesh.triangles[triangle];
+    float u = unit(rng), v = unit(rng);
+    if (u + v > 1.0f)
+    {
+      u = 1.0f - u;
+      v = 1.0f - v;
+    }
+    points.col(i) = mesh.vertices[t[0]] + u * (mesh.vertices[t[1]] - mesh.vertices[t[0]]) +
+                    v * (mesh.vertices[t[2]] - mesh.vertices[t[0]]);
+  }
+  return points;
+}
+
+Eigen::Vector3f closestPointOnTriangle(const Eigen::Vector3f& p, const Eigen::Vector3f& a,
+                                       const Eigen::Vector3f& b, const Eigen::Vector3f& c)
+{
+  const Eigen::Vector3f ab = b - a, ac = c - a, ap = p - a;
+  const float d1 = ab.dot(ap), d2 = ac.dot(ap);
+  if (d1 <= 0.0f && d2 <= 0.0f)
+    return a;
+  const Eigen::Vector3f bp = p - b;
+  const float d3 = ab.dot(bp), d4 = ac.dot(bp);
+  if (d3 >= 0.0f && d4 <= d3)
+    return b;
+  const float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    return a + d1 / (d1 - d3) * ab;
+  const Eigen::Vector3f cp = p - c;
+  const float d5 = ab.dot(cp), d6 = ac.dot(cp);
+  if (d6 >= 0.0f && d5 <= d6)
+    return c;
+  const float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    return a + d2 / (d2 - d6) * ac;
+  const float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+    return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+  const float denominator = 1.0f / (va + vb + vc);
+  return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+MeshBvh::MeshBvh(const TriangleMesh& mesh) : mesh_(mesh)
+{
+  const std::size_t count = mesh.triangles.size();
+  if (count == 0)
+    return;
+  std::vector<Eigen::AlignedBox3f> boxes(count);
+  std::vector<Eigen::Vector3f> centroids(count);
+  order_.resize(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const Eigen::Vector3i& t = mesh.triangles[i];
+    boxes[i] = Eigen::AlignedBox3f(mesh.vertices[t[0]]);
+    boxes[i].extend(mesh.vertices[t[1]]).extend(mesh.vertices[t[2]]);
+    centroids[i] = boxes[i].center();
+    order_[i] = static_cast<uint32_t>(i);
+  }
+  nodes_.reserve(2 * count);
+  build(0, static_cast<uint32_t>(count), boxes, centroids);
+}
+
+uint32_t MeshBvh::build(uint32_t begin, uint32_t end, std::vector<Eigen::AlignedBox3f>& boxes,
+                        std::vector<Eigen::Vector3f>& centroids)
+{
+  constexpr uint32_t LEAF_SIZE = 4;
+  const auto index = static_cast<uint32_t>(nodes_.size());
+  nodes_.push_back(Node{ Eigen::AlignedBox3f(), begin, end - begin });
+  Eigen::AlignedBox3f bounds, centers;
+  for (uint32_t i = begin; i < end; ++i)
+  {
+    bounds.extend(boxes[order_[i]]);
+    centers.extend(centroids[order_[i]]);
+  }
+  nodes_[index].bounds = bounds;
+  if (end - begin <= LEAF_SIZE)
+    return index;
+
+  int axis;
+  centers.sizes().maxCoeff(&axis);
+  const uint32_t middle = begin + (end - begin) / 2;
+  std::nth_element(order_.begin() + begin, order_.begin() + middle, order_.begin() + end,
+                   [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+  build(begin, middle, boxes, centroids);
+  const uint32_t second = build(middle, end, boxes, centroids);
+  nodes_[index].first = second;
+  nodes_[index].count = 0;
+  return index;
+}
+
+bool MeshBvh::closestPoint(const Eigen::Vector3f& query, Hit& hit) const
+{
+  if (nodes_.empty())
+    return false;
+  float best = std::numeric_limits<float>::infinity();
+  uint32_t stack[64];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0)
+  {
+    const uint32_t index = stack[--top];
+    const Node& node = nodes_[index];
+    if (node.bounds.squaredExteriorDistance(query) >= best)
+      continue;
+    if (node.count > 0)
+    {
+      for (uint32_t i = node.first; i < node.first + node.count; ++i)
+      {
+        const Eigen::Vector3i& t = mesh_.triangles[order_[i]];
+        const Eigen::Vector3f p = closestPointOnTriangle(
+            query, mesh_.vertices[t[0]], mesh_.vertices[t[1]], mesh_.vertices[t[2]]);
+        const float d = (p - query).squaredNorm();
+        if (d < best)
+        {
+          best = d;
+          hit.point = p;
+          hit.triangle = order_[i];
+        }
+      }
+      continue;
+    }
+    // Visit the nearer child first, it is pushed last
+    const uint32_t first = index + 1, second = node.first;
+    const bool first_nearer = nodes_[first].bounds.squaredExteriorDistance(query) <=
+                              nodes_[second].bounds.squaredExteriorDistance(query);
+    stack[top++] = first_nearer ? second : first;
+    stack[top++] = first_nearer ? first : second;
+  }
+  hit.distance = std::sqrt(best);
+  return true;
+}
+
+void MeshBvh::trianglesWithin(const Eigen::Vector3f& center, float radius,
+                              std::vector<std::size_t>& triangles) const
+{
+  triangles.clear();
+  if (nodes_.empty())
+    return;
+  const float radius_sq = radius * radius;
+  uint32_t stack[64];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0)
+  {
+    const uint32_t index = stack[--top];
+    const Node& node = nodes_[index];
+    if (node.bounds.squaredExteriorDistance(center) > radius_sq)
+      continue;
+    if (node.count == 0)
+    {
+      stack[top++] = index + 1;
+      stack[top++] = node.first;
+      continue;
+    }
+    for (uint32_t i = node.first; i < node.first + node.count; ++i)
+    {
+      const Eigen::Vector3i& t = mesh_.triangles[order_[i]];
+      const Eigen::Vector3f p = closestPointOnTriangle(center, mesh_.vertices[t[0]],
+                                                       mesh_.vertices[t[1]], mesh_.vertices[t[2]]);
+      if ((p - center).squaredNorm() <= radius_sq)
+        triangles.push_back(order_[i]);
+    }
+  }
+}
+}  // namespace welding_demo
@@ -0,0 +1,116 @@
+#include <welding_demo/warehouse_plan_store.hpp>
+
+#include <warehouse_ros/database_loader.h>
+
+namespace welding_demo
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("welding_demo.warehouse_plan_store");
+
+namespace
+{
+// Keys are formatted by PlanKey::str() only, a second format would orphan the stored plans
+std::string keyString(const std::string& kind, uint64_t key)
+{
+  return kind + "/" + PlanKey(key).str();
+}
+}  // namespace
+
+WarehousePlanStore::WarehousePlanStore(const rclcpp::Node::SharedPtr& node,
+                                       const std::string& database)
+{
+  warehouse_ros::DatabaseLoader loader(node);
+  connection_ = loader.loadDatabase();
+  if (!connection_)
+  {
+    RCLCPP_ERROR(LOGGER, "Could not load the warehouse database plugin");
+    return;
+  }
+  const std::string host = node->get_parameter_or<std::string>("warehouse_host", "localhost");
+  const int port = static_cast<int>(node->get_parameter_or<int64_t>("warehouse_port", 33829));
+  connection_->setParams(host, port, 5.0);
+  if (!connection_->connect())
+  {
+    RCLCPP_ERROR(LOGGER, "Could not connect to the warehouse at %s:%d", host.c_str(), port);
+    return;
+  }
+  trajectories_ =
+      connection_->openCollectionPtr<moveit_msgs::msg::RobotTrajectory>(database, "trajectories");
+  seeds_ = connection_->openCollectionPtr<sensor_msgs::msg::JointState>(database, "ik_seeds");
+  RCLCPP_INFO(LOGGER, "Connected to the warehouse at %s:%d", host.c_str(), port);
+}
+
+bool WarehousePlanStore::storeTrajectory(const std::string& kind, uint64_t key,
+                                         const moveit_msgs::msg::RobotTrajectory& trajectory)
+{
+  if (!trajectories_)
+    return false;
+  const std::string key_str = keyString(kind, key);
+  warehouse_ros::Query::Ptr query = trajectories_->createQuery();
+  query->append("key", key_str);
+  trajectories_->removeMessages(query);
+
+  warehouse_ros::Metadata::Ptr metadata = trajectories_->createMetadata();
+  metadata->append("key", key_str);
+  metadata->append("kind", kind);
+  trajectories_->insert(trajectory, metadata);
+  return true;
+}
+
+bool WarehousePlanStore::loadTrajectory(const std::string& kind, uint64_t key,
+                                        moveit_msgs::msg::RobotTrajectory& trajectory)
+{
+  if (!trajectories_)
+    return false;
+  warehouse_ros::Query::Ptr query = trajectories_->createQuery();
+  query->append("key", keyString(kind, key));
+  const auto result = trajectories_->queryList(query);
+  if (result.empty())
+    return false;
+  trajectory = *result.front();
+  return true;
+}
+
+std::size_t
+WarehousePlanStore::loadTrajectories(const std::string& kind,
+                                     std::vector<moveit_msgs::msg::RobotTrajectory>& trajectories)
+{
+  if (!trajectories_)
+    return 0;
+  warehouse_ros::Query::Ptr query = trajectories_->createQuery();
+  query->append("kind", kind);
+  const auto result = trajectories_->queryList(query);
+  for (const auto& message : result)
+    trajectories.push_back(*message);
+  return result.size();
+}
+
+bool WarehousePlanStore::storeSeed(uint64_t key, const std::vector<double>& positions)
+{
+  if (!seeds_)
+    return false;
+  const std::string key_str = keyString("seed", key);
+  warehouse_ros::Query::Ptr query = seeds_->createQuery();
+  query->append("key", key_str);
+  seeds_->removeMessages(query);
+
+  sensor_msgs::msg::JointState seed;
+  seed.position = positions;
+  warehouse_ros::Metadata::Ptr metadata = seeds_->createMetadata();
+  metadata->append("key", key_str);
+  seeds_->insert(seed, metadata);
+  return true;
+}
+
+bool WarehousePlanStore::loadSeed(uint64_t key, std::vector<double>& positions)
+{
+  if (!seeds_)
+    return false;
+  warehouse_ros::Query::Ptr query = seeds_->createQuery();
+  query->append("key", keyString("seed", key));
+  const auto result = seeds_->queryList(query);
+  if (result.empty())
+    return false;
+  positions = result.front()->position;
+  return true;
+}
+}  // namespace welding_demo
@@ -0,0 +1,292 @@
+#include <welding_demo/weave_pattern.hpp>
+#include <welding_demo/seam.hpp>
+#include <welding_demo/seam_spline.hpp>
+#include <welding_demo/trajectory_compression.hpp>
+#include <welding_demo/trajectory_time.hpp>
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace welding_demo
+{
+namespace
+{
+// Squared damping of the Jacobian pseudo-inverse, keeps corrections bounded near singularities
+constexpr double JACOBIAN_DAMPING = 1e-6;
+// Joint-space corner blending of the re-timing in rad, small enough to keep the weave shape
+constexpr double RETIMING_PATH_TOLERANCE = 1e-4;
+// Minimum sine of the angle between travel direction and seam normal of a weld move. Approach and
+// retract move along the seam normal and stay below it.
+constexpr double MIN_WELD_SINE = 0.5;
+
+// Unit travel directions from central differences of ``points``. Where the path does not move the
+// tangent is zero, which also switches the weave off there.
+Eigen::Matrix3Xd tangentsOf(const Eigen::Matrix3Xd& points)
+{
+  const Eigen::Index n = points.cols();
+  Eigen::Matrix3Xd tangents = Eigen::Matrix3Xd::Zero(3, n);
+  if (n < 2)
+    return tangents;
+  tangents.middleCols(1, n - 2) = points.rightCols(n - 2) - points.leftCols(n - 2);
+  tangents.col(0) = points.col(1) - points.col(0);
+  tangents.col(n - 1) = points.col(n - 1) - points.col(n - 2);
+  const Eigen::Array<double, 1, Eigen::Dynamic> norms =
+      tangents.colwise().norm().array().max(1e-12);
+  tangents.array().rowwise() /= norms;
+  return tangents;
+}
+
+Eigen::VectorXd arcLengthOf(const Eigen::Matrix3Xd& points)
+{
+  const Eigen::Index n = points.cols();
+  Eigen::VectorXd arc_length = Eigen::VectorXd::Zero(n);
+  for (Eigen::Index i = 1; i < n; ++i)
+    arc_length[i] = arc_length[i - 1] + (points.col(i) - points.col(i - 1)).norm();
+  return arc_length;
+}
+}  // namespace
+
+WeavePattern weavePatternFromString(const std::string& name)
+{
+  if (name == "zigzag")
+    return WeavePattern::ZIGZAG;
+  if (name == "triangle")
+    return WeavePattern::TRIANGLE;
+  if (name == "circular")
+    return WeavePattern::CIRCULAR;
+  return WeavePattern::NONE;
+}
+
+Eigen::Matrix3Xd weaveOffsets(const Eigen::VectorXd& arc_length, const Eigen::Matrix3Xd& tangents,
+                              const Eigen::Matrix3Xd& normals, const WeaveParameters& parameters)
+{
+  const Eigen::Index n = arc_length.size();
+  Eigen::Matrix3Xd offsets = Eigen::Matrix3Xd::Zero(3, n);
+  if (parameters.pattern == WeavePattern::NONE || parameters.wavelength <= 0.0)
+    return offsets;
+
+  // normal x tangent, left unnormalized: its length is the sine of the angle between seam normal
+  // and travel direction
+  Eigen::Matrix3Xd lateral(3, n);
+  lateral.row(0) = normals.row(1).cwiseProduct(tangents.row(2)) -
+                   normals.row(2).cwiseProduct(tangents.row(1));
+  lateral.row(1) = normals.row(2).cwiseProduct(tangents.row(0)) -
+                   normals.row(0).cwiseProduct(tangents.row(2));
+  lateral.row(2) = normals.row(0).cwiseProduct(tangents.row(1)) -
+                   normals.row(1).cwiseProduct(tangents.row(0));
+  const Eigen::ArrayXd sine_to_normal = lateral.colwise().norm().transpose().array();
+
+  // The weave covers the weld, from the first to the last sample moving across the seam normal;
+  // approach and retract before and after it are left plain. It ramps up and down over half a
+  // wavelength at both ends, so the path starts and ends on the plain seam.
+  Eigen::Index first = 0;
+  while (first < n && sine_to_normal[first] < MIN_WELD_SINE)
+    ++first;
+  Eigen::Index last = n - 1;
+  while (last > first && sine_to_normal[last] < MIN_WELD_SINE)
+    --last;
+  if (last <= first)
+    return offsets;
+  const double ramp = 0.5 * parameters.wavelength;
+  const Eigen::ArrayXd envelope =
+      (arc_length.array() - arc_length[first])
+          .min(arc_length[last] - arc_length.array())
+          .max(0.0)
+          .min(ramp) /
+      ramp;
+  const Eigen::ArrayXd weight = sine_to_normal * envelope;
+  lateral.array().rowwise() *= envelope.transpose();
+
+  const Eigen::ArrayXd phase = (2.0 * M_PI / parameters.wavelength) * arc_length.array();
+  const Eigen::ArrayXd sine = phase.sin();
+  const double a = parameters.amplitude;
+  switch (parameters.pattern)
+  {
+    case WeavePattern::ZIGZAG:
+    case WeavePattern::TRIANGLE:
+    {
+      const Eigen::ArrayXd triangle = (2.0 / M_PI) * sine.asin();
+      offsets.array() = lateral.array().rowwise() * (a * triangle).transpose();
+      if (parameters.pattern == WeavePattern::TRIANGLE)
+      {
+        // Lift the torch off the workpiece by half the amplitude when crossing the seam center
+        const Eigen::ArrayXd lift = 0.5 * a * weight * (1.0 - triangle.abs());
+        offsets.array() += normals.array().rowwise() * lift.transpose();
+      }
+      break;
+    }
+    case WeavePattern::CIRCULAR:
+    {
+      // Circles of radius ``amplitude`` that start on the plain path and lag behind it
+      const Eigen::ArrayXd along = -a * weight * (1.0 - phase.cos());
+      offsets.array() = lateral.array().rowwise() * (a * sine).transpose();
+      offsets.array() += tangents.array().rowwise() * along.transpose();
+      break;
+    }
+    case WeavePattern::NONE:
+      break;
+  }
+  return offsets;
+}
+
+void applyWeave(std::vector<geometry_msgs::msg::Pose>& waypoints,
+                const WeaveParameters& parameters)
+{
+  if (parameters.pattern == WeavePattern::NONE || waypoints.size() < 2)
+    return;
+  const SeamSpline spline(waypoints);
+  const double total = spline.length();
+  if (total <= 0.0)
+    return;
+
+  // Resample so that every weave period gets ``samples_per_period`` points. Tangents and normals
+  // come from the spline, so the pattern follows the seam between the original waypoints too.
+  const double spacing = parameters.wavelength / std::max(parameters.samples_per_period, 4.0);
+  const auto n = static_cast<Eigen::Index>(std::ceil(total / spacing)) + 1;
+  Eigen::VectorXd s = Eigen::VectorXd::LinSpaced(n, 0.0, total);
+  Eigen::Matrix3Xd resampled(3, n), tangents(3, n), normals(3, n);
+  std::vector<Eigen::Quaterniond> resampled_orientations(static_cast<std::size_t>(n));
+  for (Eigen::Index k = 0; k < n; ++k)
+  {
+    resampled.col(k) = spline.position(s[k]);
+    tangents.col(k) = spline.tangent(s[k]);
+    resampled_orientations[static_cast<std::size_t>(k)] = spline.orientation(s[k]);
+    normals.col(k) = seamNormal(resampled_orientations[static_cast<std::size_t>(k)]);
+  }
+
+  resampled += weaveOffsets(s, tangents, normals, parameters);
+
+  waypoints.resize(static_cast<std::size_t>(n));
+  for (Eigen::Index k = 0; k < n; ++k)
+  {
+    auto& pose = waypoints[static_cast<std::size_t>(k)];
+    const auto& q = resampled_orientations[static_cast<std::size_t>(k)];
+    pose.position.x = resampled(0, k);
+    pose.position.y = resampled(1, k);
+    pose.position.z = resampled(2, k);
+    pose.orientation.x = q.x();
+    pose.orientation.y = q.y();
+    pose.orientation.z = q.z();
+    pose.orientation.w = q.w();
+  }
+}
+
+bool applyWeave(moveit_msgs::msg::RobotTrajectory& trajectory, moveit::core::RobotState& state,
+                const moveit::core::JointModelGroup* group, const moveit::core::LinkModel* tip,
+                const WeaveParameters& parameters, double period)
+{
+  if (parameters.pattern == WeavePattern::NONE || trajectory.joint_trajectory.points.size() < 2)
+    return true;
+  auto& jt = trajectory.joint_trajectory;
+  trajectory_msgs::msg::JointTrajectory dense;
+  decompressTrajectory(jt, dense, period);
+
+  // Tool path and Jacobians of the plain trajectory
+  const auto n = static_cast<Eigen::Index>(dense.points.size());
+  Eigen::Matrix3Xd points(3, n), normals(3, n);
+  std::vector<Eigen::MatrixXd> jacobians(dense.points.size());
+  for (Eigen::Index i = 0; i < n; ++i)
+  {
+    const auto& point = dense.points[static_cast<std::size_t>(i)];
+    state.setVariablePositions(jt.joint_names, point.positions);
+    state.updateLinkTransforms();
+    const Eigen::Isometry3d& tool = state.getGlobalLinkTransform(tip);
+    points.col(i) = tool.translation();
+    normals.col(i) = seamNormal(tool);
+    state.getJacobian(group, tip, Eigen::Vector3d::Zero(), jacobians[static_cast<std::size_t>(i)]);
+  }
+  const Eigen::Matrix3Xd offsets =
+      weaveOffsets(arcLengthOf(points), tangentsOf(points), normals, parameters);
+
+  // Joint corrections for a pure translation of the tool, orientation held
+  const auto dof = static_cast<Eigen::Index>(jt.joint_names.size());
+  Eigen::MatrixXd positions(n, dof);
+  Eigen::VectorXd times(n);
+  Eigen::VectorXd twist = Eigen::VectorXd::Zero(6);
+  Eigen::VectorXd group_positions;
+  for (Eigen::Index i = 0; i < n; ++i)
+  {
+    auto& point = dense.points[static_cast<std::size_t>(i)];
+    const Eigen::MatrixXd& jacobian = jacobians[static_cast<std::size_t>(i)];
+    twist.head<3>() = offsets.col(i);
+    const Eigen::MatrixXd jjt =
+        jacobian * jacobian.transpose() + JACOBIAN_DAMPING * Eigen::MatrixXd::Identity(6, 6);
+    const Eigen::VectorXd correction = jacobian.transpose() * jjt.ldlt().solve(twist);
+
+    state.setVariablePositions(jt.joint_names, point.positions);
+    state.copyJointGroupPositions(group, group_positions);
+    state.setJointGroupPositions(group, group_positions + correction);
+    if (!state.satisfiesBounds(group))
+      return false;
+    for (Eigen::Index j = 0; j < dof; ++j)
+      positions(i, j) = state.getVariablePosition(jt.joint_names[static_cast<std::size_t>(j)]);
+    times[i] = toSec(point.time_from_start);
+  }
+
+  const Eigen::MatrixXd velocities = estimateVelocities(times, positions);
+  const Eigen::MatrixXd accelerations = estimateVelocities(times, velocities);
+  for (Eigen::Index i = 0; i < n; ++i)
+  {
+    auto& point = dense.points[static_cast<std::size_t>(i)];
+    const Eigen::RowVectorXd q = positions.row(i);
+    const Eigen::RowVectorXd v = velocities.row(i);
+    const Eigen::RowVectorXd a = accelerations.row(i);
+    point.positions.assign(q.data(), q.data() + dof);
+    point.velocities.assign(v.data(), v.data() + dof);
+    point.accelerations.assign(a.data(), a.data() + dof);
+  }
+
+  // At the planned timing the weave may ask for more joint speed than the arm has
+  bool within_limits = true;
+  for (Eigen::Index j = 0; j < dof && within_limits; ++j)
+  {
+    const moveit::core::VariableBounds& bounds =
+        state.getRobotModel()->getVariableBounds(jt.joint_names[static_cast<std::size_t>(j)]);
+    within_limits =
+        (!bounds.velocity_bounded_ ||
+         velocities.col(j).cwiseAbs().maxCoeff() <= bounds.max_velocity_) &&
+        (!bounds.acceleration_bounded_ ||
+         accelerations.col(j).cwiseAbs().maxCoeff() <= bounds.max_acceleration_);
+  }
+  if (within_limits)
+  {
+    jt = std::move(dense);
+    return true;
+  }
+
+  robot_trajectory::RobotTrajectory retimed(state.getRobotModel(), group);
+  retimed.setRobotTrajectoryMsg(state, dense);
+  const trajectory_processing::TimeOptimalTrajectoryGeneration totg(RETIMING_PATH_TOLERANCE,
+                                                                    period);
+  if (!totg.computeTimeStamps(retimed) || retimed.empty())
+    return false;
+  moveit_msgs::msg::RobotTrajectory retimed_msg;
+  retimed.getRobotTrajectoryMsg(retimed_msg);
+  auto& retimed_jt = retimed_msg.joint_trajectory;
+  retimed_jt.header = jt.header;
+
+  // Time-optimal is faster than the welding speed where the limits allow it; slow the whole
+  // trajectory down uniformly to the planned duration, which keeps it within the limits
+  const double planned_duration = times[n - 1];
+  const double duration = toSec(retimed_jt.points.back().time_from_start);
+  if (duration > 0.0 && duration < planned_duration)
+  {
+    const double scale = planned_duration / duration;
+    for (auto& point : retimed_jt.points)
+    {
+      point.time_from_start = fromSec(toSec(point.time_from_start) * scale);
+      for (double& v : point.velocities)
+        v /= scale;
+      for (double& a : point.accelerations)
+        a /= scale * scale;
+    }
+  }
+  jt = std::move(retimed_jt);
+  return true;
+}
+}  // namespace welding_demo
@@ -0,0 +1,367 @@
+#include <welding_demo/welding_config.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace welding_demo
+{
+static const rclcpp::Logger LOGGER = rclcpp::get_logger("welding_demo.welding_config");
+
+namespace
+{
+// Sets a field from a parameter, returns an empty string or the reason the value was refused
+using Setter = std::function<std::string(WeldingConfig&, const rclcpp::Parameter&)>;
+
+struct ParameterSpec
+{
+  std::string name;
+  rclcpp::ParameterValue default_value;
+  bool live;
+  Setter set;
+};
+
+// Parameters given as overrides are declared from the YAML type, so integers are accepted where
+// a double is expected
+bool toDouble(const rclcpp::Parameter& parameter, double& value)
+{
+  if (parameter.get_type() == rclcpp::ParameterType::PARAMETER_DOUBLE)
+    value = parameter.as_double();
+  else if (parameter.get_type() == rclcpp::ParameterType::PARAMETER_INTEGER)
+    value = static_cast<double>(parameter.as_int());
+  else
+    return false;
+  return std::isfinite(value);
+}
+
+Setter doubleSetter(double WeldingConfig::*field, double min, double max = INFINITY)
+{
+  return [field, min, max](WeldingConfig& config, const rclcpp::Parameter& parameter) {
+    double value;
+    if (!toDouble(parameter, value))
+      return std::string("expected a number");
+    if (value < min || value > max)
+      return "must be in [" + std::to_string(min) + ", " + std::to_string(max) + "]";
+    config.*field = value;
+    return std::string();
+  };
+}
+
+// Like doubleSetter, but the minimum itself is not allowed
+Setter positiveSetter(double WeldingConfig::*field, double max = INFINITY)
+{
+  return [field, max](WeldingConfig& config, const rclcpp::Parameter& parameter) {
+    double value;
+    if (!toDouble(parameter, value))
+      return std::string("expected a number");
+    if (value <= 0.0 || value > max)
+      return "must be in (0, " + std::to_string(max) + "]";
+    config.*field = value;
+    return std::string();
+  };
+}
+
+Setter boolSetter(bool WeldingConfig::*field)
+{
+  return [field](WeldingConfig& config, const rclcpp::Parameter& parameter) {
+    if (parameter.get_type() != rclcpp::ParameterType::PARAMETER_BOOL)
+      return std::string("expected true or false");
+    config.*field = parameter.as_bool();
+    return std::string();
+  };
+}
+
+Setter intSetter(int WeldingConfig::*field, int min, int max)
+{
+  return [field, min, max](WeldingConfig& config, const rclcpp::Parameter& parameter) {
+    if (parameter.get_type() != rclcpp::ParameterType::PARAMETER_INTEGER)
+      return std::string("expected an integer");
+    const int64_t value = parameter.as_int();
+    if (value < min || value > max)
+      return "must be in [" + std::to_string(min) + ", " + std::to_string(max) + "]";
+    config.*field = static_cast<int>(value);
+    return std::string();
+  };
+}
+
+Setter stringSetter(std::string WeldingConfig::*field, std::vector<std::string> choices = {})
+{
+  return [field, choices](WeldingConfig& config, const rclcpp::Parameter& parameter) {
+    if (parameter.get_type() != rclcpp::ParameterType::PARAMETER_STRING)
+      return std::string("expected a string");
+    const std::string value = parameter.as_string();
+    if (!choices.empty() && std::find(choices.begin(), choices.end(), value) == choices.end())
+    {
+      std::string message = "must be one of";
+      for (const auto& choice : choices)
+        message += " '" + choice + "'";
+      return message;
+    }
+    config.*field = value;
+    return std::string();
+  };
+}
+
+Setter arraySetter(std::vector<double> WeldingConfig::*field, std::size_t size = 0)
+{
+  return [field, size](WeldingConfig& config, const rclcpp::Parameter& parameter) {
+    std::vector<double> value;
+    if (parameter.get_type() == rclcpp::ParameterType::PARAMETER_DOUBLE_ARRAY)
+      value = parameter.as_double_array();
+    else if (parameter.get_type() == rclcpp::ParameterType::PARAMETER_INTEGER_ARRAY)
+      for (int64_t v : parameter.as_integer_array())
+        value.push_back(static_cast<double>(v));
+    else if (parameter.get_type() != rclcpp::ParameterType::PARAMETER_NOT_SET)
+      return std::string("expected a list of numbers");
+    if (size > 0 && value.size() != size)
+      return "expected " + std::to_string(size) + " values";
+    config.*field = value;
+    return std::string();
+  };
+}
+
+const std::vector<ParameterSpec>& parameterSpecs()
+{
+  using C = WeldingConfig;
+  static const WeldingConfig d;
+  static const std::vector<ParameterSpec> specs = {
+    { "planning_group", rclcpp::ParameterValue(d.planning_group), false,
+      stringSetter(&C::planning_group) },
+    { "reachability_map", rclcpp::ParameterValue(d.reachability_map), false,
+      stringSetter(&C::reachability_map) },
+    { "transit_roadmap", rclcpp::ParameterValue(d.transit_roadmap), false,
+      stringSetter(&C::transit_roadmap) },
+    { "transit_joint_tolerance", rclcpp::ParameterValue(d.transit_joint_tolerance), false,
+      positiveSetter(&C::transit_joint_tolerance) },
+    { "plan_store", rclcpp::ParameterValue(d.plan_store), false,
+      stringSetter(&C::plan_store, { "warehouse", "file", "none" }) },
+    { "plan_store_file", rclcpp::ParameterValue(d.plan_store_file), false,
+      stringSetter(&C::plan_store_file) },
+    { "compression_tolerance", rclcpp::ParameterValue(d.compression_tolerance), false,
+      doubleSetter(&C::compression_tolerance, 0.0) },
+    { "decompression_period", rclcpp::ParameterValue(d.decompression_period), false,
+      positiveSetter(&C::decompression_period) },
+    { "profile_startup", rclcpp::ParameterValue(d.profile_startup), false,
+      boolSetter(&C::profile_startup) },
+    { "planning_mode", rclcpp::ParameterValue(d.planning_mode), false,
+      stringSetter(&C::planning_mode, { "move_group", "local" }) },
+    { "cloud_buffer", rclcpp::ParameterValue(d.cloud_buffer), false,
+      stringSetter(&C::cloud_buffer) },
+    { "part_mesh", rclcpp::ParameterValue(d.part_mesh), false, stringSetter(&C::part_mesh) },
+    { "part_seams", rclcpp::ParameterValue(d.part_seams), false, stringSetter(&C::part_seams) },
+    { "part_mesh_scale", rclcpp::ParameterValue(d.part_mesh_scale), false,
+      positiveSetter(&C::part_mesh_scale) },
+    { "execution_action", rclcpp::ParameterValue(d.execution_action), false,
+      stringSetter(&C::execution_action) },
+    { "fixture_id", rclcpp::ParameterValue(d.fixture_id), true, stringSetter(&C::fixture_id) },
+    { "circle_center", rclcpp::ParameterValue(d.circle_center), true,
+      arraySetter(&C::circle_center, 3) },
+    { "circle_radius", rclcpp::ParameterValue(d.circle_radius), true,
+      positiveSetter(&C::circle_radius) },
+    { "circle_angle_step", rclcpp::ParameterValue(d.circle_angle_step), true,
+      positiveSetter(&C::circle_angle_step, M_PI) },
+    { "circle_points", rclcpp::ParameterValue(d.circle_points), true,
+      intSetter(&C::circle_points, 0, 100000) },
+    { "circle_overlap", rclcpp::ParameterValue(d.circle_overlap), true,
+      doubleSetter(&C::circle_overlap, -1.0, 1.0) },
+    { "eef_step", rclcpp::ParameterValue(d.eef_step), true, positiveSetter(&C::eef_step) },
+    { "jump_threshold", rclcpp::ParameterValue(d.jump_threshold), true,
+      doubleSetter(&C::jump_threshold, 0.0) },
+    { "min_manipulability", rclcpp::ParameterValue(d.min_manipulability), true,
+      doubleSetter(&C::min_manipulability, 0.0) },
+    { "approach_distance", rclcpp::ParameterValue(d.approach_distance), true,
+      doubleSetter(&C::approach_distance, 0.0) },
+    { "retract_distance", rclcpp::ParameterValue(d.retract_distance), true,
+      doubleSetter(&C::retract_distance, 0.0) },
+    { "smoothing_half_window", rclcpp::ParameterValue(d.smoothing_half_window), true,
+      intSetter(&C::smoothing_half_window, 0, 50) },
+    { "smoothing_order", rclcpp::ParameterValue(d.smoothing_order), true,
+      intSetter(&C::smoothing_order, 0, 10) },
+    { "max_tcp_deviation", rclcpp::ParameterValue(d.max_tcp_deviation), true,
+      positiveSetter(&C::max_tcp_deviation) },
+    { "max_orientation_deviation", rclcpp::ParameterValue(d.max_orientation_deviation), true,
+      positiveSetter(&C::max_orientation_deviation, M_PI) },
+    { "weave_pattern", rclcpp::ParameterValue(d.weave_pattern), true,
+      stringSetter(&C::weave_pattern, { "none", "zigzag", "triangle", "circular" }) },
+    { "weave_amplitude", rclcpp::ParameterValue(d.weave_amplitude), true,
+      doubleSetter(&C::weave_amplitude, 0.0) },
+    { "weave_wavelength", rclcpp::ParameterValue(d.weave_wavelength), true,
+      positiveSetter(&C::weave_wavelength) },
+    { "weave_layer", rclcpp::ParameterValue(d.weave_layer), true,
+      stringSetter(&C::weave_layer, { "plan", "execute" }) },
+    { "weave_period", rclcpp::ParameterValue(d.weave_period), true,
+      positiveSetter(&C::weave_period) },
+    { "pass_lateral_offsets", rclcpp::ParameterValue(d.pass_lateral_offsets), true,
+      arraySetter(&C::pass_lateral_offsets) },
+    { "pass_lifts", rclcpp::ParameterValue(d.pass_lifts), true, arraySetter(&C::pass_lifts) },
+    { "roi_min", rclcpp::ParameterValue(d.roi_min), true, arraySetter(&C::roi_min, 3) },
+    { "roi_max", rclcpp::ParameterValue(d.roi_max), true, arraySetter(&C::roi_max, 3) },
+    { "voxel_size", rclcpp::ParameterValue(d.voxel_size), true,
+      doubleSetter(&C::voxel_size, 0.0) },
+    { "seam_source", rclcpp::ParameterValue(d.seam_source), true,
+      stringSetter(&C::seam_source, { "circle", "scan", "cad" }) },
+    { "part_pose", rclcpp::ParameterValue(d.part_pose), true, arraySetter(&C::part_pose, 6) },
+    { "register_part", rclcpp::ParameterValue(d.register_part), true,
+      boolSetter(&C::register_part) },
+    { "registration_max_distance", rclcpp::ParameterValue(d.registration_max_distance), true,
+      positiveSetter(&C::registration_max_distance) },
+    { "registration_iterations", rclcpp::ParameterValue(d.registration_iterations), true,
+      intSetter(&C::registration_iterations, 1, 1000) },
+    { "plane_distance_threshold", rclcpp::ParameterValue(d.plane_distance_threshold), true,
+      positiveSetter(&C::plane_distance_threshold) },
+    { "max_planes", rclcpp::ParameterValue(d.max_planes), true, intSetter(&C::max_planes, 2, 64) },
+    { "seam_sample_step", rclcpp::ParameterValue(d.seam_sample_step), true,
+      positiveSetter(&C::seam_sample_step) },
+    { "min_seam_length", rclcpp::ParameterValue(d.min_seam_length), true,
+      doubleSetter(&C::min_seam_length, 0.0) },
+    { "max_butt_gap", rclcpp::ParameterValue(d.max_butt_gap), true,
+      doubleSetter(&C::max_butt_gap, 0.0) },
+    { "seam_spline_step", rclcpp::ParameterValue(d.seam_spline_step), true,
+      doubleSetter(&C::seam_spline_step, 0.0) },
+  };
+  return specs;
+}
+
+const ParameterSpec* findSpec(const std::string& name)
+{
+  for (const auto& spec : parameterSpecs())
+    if (spec.name == name)
+      return &spec;
+  return nullptr;
+}
+}  // namespace
+
+std::string WeldingConfig::validate() const
+{
+  if (smoothing_half_window > 0 && smoothing_order >= 2 * smoothing_half_window + 1)
+    return "smoothing_order must be smaller than the filter window (2 * smoothing_half_window + 1)";
+  if (weave_pattern != "none" && weave_amplitude >= 0.5 * weave_wavelength)
+    return "weave_amplitude must be smaller than half the weave_wavelength";
+  for (std::size_t i = 0; i < 3; ++i)
+    if (roi_min[i] >= roi_max[i])
+      return "roi_min must be smaller than roi_max on every axis";
+  return std::string();
+}
+
+void WeldingConfig::updateDerived()
+{
+  center = Eigen::Vector3d(circle_center[0], circle_center[1], circle_center[2]);
+  circle_sampling.count = static_cast<std::size_t>(circle_points);
+  circle_sampling.max_spacing = circle_radius * circle_angle_step;
+  circle_sampling.overlap = circle_overlap;
+  smoothing.half_window = smoothing_half_window;
+  smoothing.order = smoothing_order;
+  smoothing.max_tcp_deviation = max_tcp_deviation;
+  smoothing.max_orientation_deviation = max_orientation_deviation;
+  weave.pattern = weavePatternFromString(weave_pattern);
+  weave.amplitude = weave_amplitude;
+  weave.wavelength = weave_wavelength;
+  weave_at_execution = weave_layer == "execute";
+  pass_offsets.assign(std::max(pass_lateral_offsets.size(), pass_lifts.size()), PassOffset());
+  for (std::size_t i = 0; i < pass_offsets.size(); ++i)
+  {
+    pass_offsets[i].lateral = i < pass_lateral_offsets.size() ? pass_lateral_offsets[i] : 0.0;
+    pass_offsets[i].lift = i < pass_lifts.size() ? pass_lifts[i] : 0.0;
+  }
+  preprocessing.roi = Eigen::AlignedBox3f(
+      Eigen::Vector3d(roi_min[0], roi_min[1], roi_min[2]).cast<float>(),
+      Eigen::Vector3d(roi_max[0], roi_max[1], roi_max[2]).cast<float>());
+  preprocessing.voxel_size = static_cast<float>(voxel_size);
+  seam_extraction.distance_threshold = static_cast<float>(plane_distance_threshold);
+  seam_extraction.max_planes = static_cast<std::size_t>(max_planes);
+  seam_extraction.sample_step = static_cast<float>(seam_sample_step);
+  seam_extraction.min_length = static_cast<float>(min_seam_length);
+  seam_extraction.max_gap = static_cast<float>(max_butt_gap);
+  // Raster cells of the point spacing: gaps from two cells up stay open, holes inside the plates
+  // do not split them
+  seam_extraction.gap_resolution =
+      static_cast<float>(voxel_size > 0.0 ? voxel_size : plane_distance_threshold);
+  part_transform = Eigen::Translation3d(part_pose[0], part_pose[1], part_pose[2]) *
+                   Eigen::AngleAxisd(part_pose[5], Eigen::Vector3d::UnitZ()) *
+                   Eigen::AngleAxisd(part_pose[4], Eigen::Vector3d::UnitY()) *
+                   Eigen::AngleAxisd(part_pose[3], Eigen::Vector3d::UnitX());
+  cad_seams.sample_step = static_cast<float>(seam_sample_step);
+  registration.max_distance = static_cast<float>(registration_max_distance);
+  registration.max_iterations = static_cast<std::size_t>(registration_iterations);
+}
+
+WeldingConfigServer::WeldingConfigServer(const rclcpp::Node::SharedPtr& node)
+{
+  auto config = std::make_shared<WeldingConfig>();
+  std::vector<rclcpp::Parameter> rejected;
+  for (const auto& spec : parameterSpecs())
+  {
+    // With automatically_declare_parameters_from_overrides the overridden ones already exist
+    if (!node->has_parameter(spec.name))
+      node->declare_parameter(spec.name, spec.default_value);
+    const std::string error = spec.set(*config, node->get_parameter(spec.name));
+    if (!error.empty())
+    {
+      RCLCPP_ERROR(LOGGER, "Invalid parameter '%s' (%s), using the default", spec.name.c_str(),
+                   error.c_str());
+      rejected.emplace_back(spec.name, spec.default_value);
+    }
+  }
+  const std::string error = config->validate();
+  if (!error.empty())
+  {
+    RCLCPP_ERROR(LOGGER, "Invalid configuration (%s), using the defaults", error.c_str());
+    config = std::make_shared<WeldingConfig>();
+    rejected.clear();
+    for (const auto& spec : parameterSpecs())
+      rejected.emplace_back(spec.name, spec.default_value);
+  }
+  config->updateDerived();
+  config_ = config;
+
+  // Rejected values are replaced by the defaults in use, so the parameters show what is running.
+  // A value of the wrong type cannot be replaced on a statically typed parameter.
+  for (const auto& parameter : rejected)
+  {
+    const auto result = node->set_parameter(parameter);
+    if (!result.successful)
+      RCLCPP_WARN(LOGGER, "Could not reset parameter '%s' to its default: %s",
+                  parameter.get_name().c_str(), result.reason.c_str());
+  }
+
+  callback_handle_ = node->add_on_set_parameters_callback(
+      [this](const std::vector<rclcpp::Parameter>& parameters) {
+        return onSetParameters(parameters);
+      });
+}
+
+rcl_interfaces::msg::SetParametersResult
+WeldingConfigServer::onSetParameters(const std::vector<rclcpp::Parameter>& parameters)
+{
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  auto config = std::make_shared<WeldingConfig>(*get());
+  for (const auto& parameter : parameters)
+  {
+    const ParameterSpec* spec = findSpec(parameter.get_name());
+    if (!spec)
+      continue;
+    std::string error = spec->live ? spec->set(*config, parameter) : "requires a restart";
+    if (!error.empty())
+    {
+      result.successful = false;
+      result.reason = parameter.get_name() + ": " + error;
+      return result;
+    }
+  }
+  const std::string error = config->validate();
+  if (!error.empty())
+  {
+    result.successful = false;
+    result.reason = error;
+    return result;
+  }
+  config->updateDerived();
+  std::atomic_store(&config_, WeldingConfigConstPtr(config));
+  for (const auto& parameter : parameters)
+    if (findSpec(parameter.get_name()))
+      RCLCPP_INFO(LOGGER, "Set '%s' to %s", parameter.get_name().c_str(),
+                  parameter.value_to_string().c_str());
+  return result;
+}
+}  // namespace welding_demo
@@ -0,0 +1,20 @@
+#include <welding_demo/welding_demo.hpp>
+
+// Standalone process running the welding demo component. Intra-process communication is enabled
+// so a driver component added to the same executor hands its clouds over without copies.
+int main(int argc, char** argv)
+{
+  rclcpp::init(argc, argv);
+  rclcpp::NodeOptions options;
+  options.use_intra_process_comms(true);
+  auto demo = std::make_shared<welding_demo::WeldingDemo>(options);
+
+  // We spin up a SingleThreadedExecutor for the current state monitor to get information
+  // about the robot's state.
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(demo->get_node_base_interface());
+  executor.spin();
+
+  rclcpp::shutdown();
+  return 0;
+}
@@ -1,3 +1,4 @@
+#include <moveit/common_planning_interface_objects/common_objects.h>
 #include <moveit/move_group_interface/move_group_interface.h>
 #include <moveit/planning_scene_interface/planning_scene_interface.h>
 
@@ -8,27 +9,120 @@
 #include <moveit_msgs/msg/collision_object.hpp>
 
 #include <moveit_visual_tools/moveit_visual_tools.h>
+#include <rclcpp_components/register_node_macro.hpp>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 #include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
 #include <tf2_eigen/tf2_eigen.hpp>
 
+#include <welding_demo/allocation_counter.hpp>
+#include <welding_demo/async_execution.hpp>
+#include <welding_demo/cad_seam_import.hpp>
+#include <welding_demo/closed_seam_sampling.hpp>
+#include <welding_demo/cloud_preprocessing.hpp>
+#include <welding_demo/cloud_ring_buffer.hpp>
+#include <welding_demo/compressing_plan_store.hpp>
+#include <welding_demo/file_plan_store.hpp>
+#include <welding_demo/local_cartesian_planner.hpp>
+#include <welding_demo/multi_pass_planner.hpp>
+#include <welding_demo/plan_store.hpp>
+#include <welding_demo/pose_batch.hpp>
+#include <welding_demo/reachability_map.hpp>
+#include <welding_demo/scan_registration.hpp>
+#include <welding_demo/seam.hpp>
+#include <welding_demo/seam_buffer.hpp>
+#include <welding_demo/seam_endpoints.hpp>
+#include <welding_demo/seam_extraction.hpp>
+#include <welding_demo/seam_sequencer.hpp>
+#include <welding_demo/seam_spline.hpp>
+#include <welding_demo/startup_profiler.hpp>
+#include <welding_demo/trajectory_handle.hpp>
+#include <welding_demo/trajectory_smoothing.hpp>
+#include <welding_demo/transit_planner.hpp>
+#include <welding_demo/triangle_mesh.hpp>
+#include <welding_demo/warehouse_plan_store.hpp>
+#include <welding_demo/weave_pattern.hpp>
+#include <welding_demo/welding_config.hpp>
+#include <welding_demo/welding_demo.hpp>
+
 // All source files that use ROS logging should define a file-specific
 // static const rclcpp::Logger named LOGGER, located at the top of the file
 // and inside the namespace with the narrowest scope (if there is one)
 static const rclcpp::Logger LOGGER = rclcpp::get_logger("welding_demo");
 
-int main(int argc, char** argv)
+namespace welding_demo
+{
+WeldingDemo::WeldingDemo(const rclcpp::NodeOptions& options)
 {
-  rclcpp::init(argc, argv);
-  rclcpp::NodeOptions node_options;
+  rclcpp::NodeOptions node_options(options);
   node_options.automatically_declare_parameters_from_overrides(true);
-  auto welding_demo_node = rclcpp::Node::make_shared("welding_demo_node", node_options);
+  node_ = std::make_shared<rclcpp::Node>("welding_demo_node", node_options);
+
+  // Taking and publishing unique_ptr messages lets intra-process communication move them
+  cloud_subscription_ = node_->create_subscription<sensor_msgs::msg::PointCloud2>(
+      "points", rclcpp::SensorDataQoS(),
+      [this](sensor_msgs::msg::PointCloud2::UniquePtr cloud) { onPointCloud(std::move(cloud)); });
+  trajectory_publisher_ =
+      node_->create_publisher<trajectory_msgs::msg::JointTrajectory>("welded_trajectories", 10);
+
+  // On shutdown the motion is canceled before the context goes down, a cancel request can not be
+  // sent afterwards
+  pre_shutdown_ = node_->get_node_base_interface()->get_context()->add_pre_shutdown_callback(
+      [this]() { stop(); });
+
+  // The node is spun by the executor of the process or container, the current state monitor
+  // gets the robot's state from there.
+  thread_ = std::thread([this]() { run(); });
+}
+
+WeldingDemo::~WeldingDemo()
+{
+  // Unloading the component stops the loop while the context is still up
+  node_->get_node_base_interface()->get_context()->remove_pre_shutdown_callback(pre_shutdown_);
+  stop();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void WeldingDemo::stop()
+{
+  // A prompt waiting for the 'next' button is released, the loop checks the flag after it
+  std::lock_guard<std::mutex> lock(stop_mutex_);
+  stop_ = true;
+  if (remote_control_)
+    remote_control_->setAutonomous();
+  if (in_flight_)
+    in_flight_->cancel();
+}
+
+std::shared_ptr<const sensor_msgs::msg::PointCloud2> WeldingDemo::latestCloud() const
+{
+  std::lock_guard<std::mutex> lock(cloud_mutex_);
+  return latest_cloud_;
+}
 
-  // We spin up a SingleThreadedExecutor for the current state monitor to get information
-  // about the robot's state.
-  rclcpp::executors::SingleThreadedExecutor executor;
-  executor.add_node(welding_demo_node);
-  std::thread([&executor]() { executor.spin(); }).detach();
+void WeldingDemo::onPointCloud(sensor_msgs::msg::PointCloud2::UniquePtr cloud)
+{
+  std::shared_ptr<const sensor_msgs::msg::PointCloud2> shared(std::move(cloud));
+  std::lock_guard<std::mutex> lock(cloud_mutex_);
+  latest_cloud_ = std::move(shared);
+}
+
+void WeldingDemo::run()
+{
+  const rclcpp::Node::SharedPtr& welding_demo_node = node_;
+  welding_demo::StartupProfiler startup;
+
+  // Configuration
+  // ^^^^^^^^^^^^^
+  // All tunables are ROS parameters (see ``WeldingConfig``). Startup settings are read once below,
+  // everything else is re-read at the start of every cycle, so it can be changed with
+  // ``ros2 param set`` while the node runs.
+  startup.phase("configuration");
+  welding_demo::WeldingConfigServer config_server(welding_demo_node);
+  const welding_demo::WeldingConfigConstPtr startup_config = config_server.get();
 
   // BEGIN_TUTORIAL
   //
@@ -38,22 +132,40 @@ int main(int argc, char** argv)
   // MoveIt operates on sets of joints called "planning groups" and stores them in an object called
   // the ``JointModelGroup``. Throughout MoveIt, the terms "planning group" and "joint model group"
   // are used interchangeably.
-  static const std::string PLANNING_GROUP = "ur_manipulator";
+  const std::string& planning_group = startup_config->planning_group;
+
+  // The robot model, including the kinematics solvers, is parsed once per process and shared by
+  // everything that needs it (move_group interface, visual tools, scratch states). Holding the
+  // loader keeps it cached for the lifetime of the node. This cache lives in memory only: a
+  // restarted node parses the model again, across restarts only the xacro expansion of the robot
+  // description is cached (on disk, by the launch file).
+  startup.phase("robot model");
+  const robot_model_loader::RobotModelLoaderPtr robot_model_loader =
+      moveit::planning_interface::getSharedRobotModelLoader(welding_demo_node,
+                                                            "robot_description");
 
   // The
   // :moveit_codedir:`MoveGroupInterface<moveit_ros/planning_interface/move_group_interface/include/moveit/move_group_interface/move_group_interface.h>`
   // class can be easily set up using just the name of the planning group you would like to control
   // and plan for.
-  moveit::planning_interface::MoveGroupInterface move_group(welding_demo_node, PLANNING_GROUP);
+  startup.phase("move group interface");
+  moveit::planning_interface::MoveGroupInterface move_group(welding_demo_node, planning_group);
 
   // We will use the
   // :moveit_codedir:`PlanningSceneInterface<moveit_ros/planning_interface/planning_scene_interface/include/moveit/planning_scene_interface/planning_scene_interface.h>`
   // class to add and remove collision objects in our "virtual world" scene
+  startup.phase("planning scene interface");
   moveit::planning_interface::PlanningSceneInterface planning_scene_interface;
 
+  // Raw pointers are frequently used to refer to the planning group for improved performance.
+  const moveit::core::JointModelGroup* joint_model_group =
+      move_group.getRobotModel()->getJointModelGroup(planning_group);
+  const Eigen::VectorXd max_joint_velocities = welding_demo::maxJointVelocities(joint_model_group);
+
   // Visualization
   // ^^^^^^^^^^^^^
   namespace rvt = rviz_visual_tools;
+  startup.phase("visual tools");
   moveit_visual_tools::MoveItVisualTools visual_tools(
       welding_demo_node, "base_link", "welding_demo_tutorial", move_group.getRobotModel());
 
@@ -63,6 +175,12 @@ int main(int argc, char** argv)
    */
   /* via buttons and keyboard shortcuts in RViz */
   visual_tools.loadRemoteControl();
+  {
+    std::lock_guard<std::mutex> lock(stop_mutex_);
+    remote_control_ = visual_tools.getRemoteControl();
+    if (stop_)
+      remote_control_->setAutonomous();
+  }
 
   // RViz provides many types of markers, in this demo we will use text, cylinders, and spheres
   Eigen::Isometry3d text_pose = Eigen::Isometry3d::Identity();
@@ -88,12 +206,346 @@ int main(int argc, char** argv)
             move_group.getJointModelGroupNames().end(),
             std::ostream_iterator<std::string>(std::cout, ", "));
 
+  startup.phase("reachability map");
+  // Reachability map
+  // ^^^^^^^^^^^^^^^^
+  //
+  // A precomputed map (see reachability_map_builder) lets us reject seams that can not be welded
+  // from the current workpiece placement before any IK is run.
+  welding_demo::ReachabilityMap reachability_map;
+  const std::string& reachability_map_file = startup_config->reachability_map;
+  if (!reachability_map_file.empty())
+  {
+    if (reachability_map.load(reachability_map_file))
+      RCLCPP_INFO(LOGGER, "Loaded reachability map '%s'", reachability_map_file.c_str());
+    else
+      RCLCPP_WARN(LOGGER, "Could not load reachability map '%s'", reachability_map_file.c_str());
+  }
+
+  // Approach, retract and transit moves
+  // ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+  //
+  // Every seam is entered and left along its surface normal (seamNormal()), the torch backs off
+  // the workpiece. Joint-space transits between the seams are cached in a roadmap, so repeated air
+  // moves cost no planning time after the first part.
+  startup.phase("transit roadmap");
+  const std::string& transit_roadmap_file = startup_config->transit_roadmap;
+  welding_demo::TransitPlanner transit_planner(move_group,
+                                               startup_config->transit_joint_tolerance);
+  if (!transit_roadmap_file.empty() && transit_planner.roadmap().load(transit_roadmap_file))
+    RCLCPP_INFO(LOGGER, "Loaded transit roadmap with %zu nodes and %zu edges",
+                transit_planner.roadmap().nodeCount(), transit_planner.roadmap().edgeCount());
+
+  // Plan storage
+  // ^^^^^^^^^^^^
+  //
+  // Seam trajectories, transit plans and IK seeds are kept in a plan store, so a restarted node or
+  // another cell with the same fixture warm-starts from the plans computed before. The store is
+  // either the warehouse database or, for cells without a database process, an embedded log file.
+  startup.phase("plan store");
+  welding_demo::PlanStorePtr plan_store;
+  const std::string& plan_store_type = startup_config->plan_store;
+  if (plan_store_type == "warehouse")
+  {
+    auto warehouse = std::make_shared<welding_demo::WarehousePlanStore>(welding_demo_node);
+    if (warehouse->connected())
+      plan_store = warehouse;
+  }
+  else if (plan_store_type == "file")
+  {
+    auto file = std::make_shared<welding_demo::FilePlanStore>(startup_config->plan_store_file);
+    if (file->isOpen())
+      plan_store = file;
+  }
+  // With a ``compression_tolerance``, stored plans are compressed to piecewise cubic segments
+  // within that joint tolerance, which cuts their size by an order of magnitude. They are
+  // resampled before execution, so the executed weld path deviates by up to the tolerance; the
+  // default of 0 stores plans exactly.
+  if (plan_store && startup_config->compression_tolerance > 0.0)
+    plan_store = std::make_shared<welding_demo::CompressingPlanStore>(
+        plan_store, startup_config->compression_tolerance, startup_config->decompression_period);
+  if (plan_store)
+  {
+    // Stored plans are in the controller's joint order, the roadmap in the group's variable order
+    std::vector<moveit_msgs::msg::RobotTrajectory> transits;
+    plan_store->loadTrajectories("transit", transits);
+    std::size_t inserted = 0;
+    for (const auto& transit : transits)
+      inserted += transit_planner.roadmap().insert(transit, joint_model_group->getVariableNames());
+    RCLCPP_INFO(LOGGER, "Warm-started transit roadmap with %zu of %zu stored plans", inserted,
+                transits.size());
+  }
+
+  // Part model
+  // ^^^^^^^^^^
+  // Seams can be defined on the CAD mesh of the part (``part_mesh``, ``part_seams``): the seam
+  // curves are projected onto the mesh surface every cycle, with the part placed at ``part_pose``.
+  // With ``register_part`` the actual placement is measured by aligning each scan to a cloud
+  // sampled from the mesh, and the seams are moved from the nominal to the measured placement.
+  startup.phase("part mesh");
+  constexpr std::size_t PART_MODEL_POINTS = 20000;
+  constexpr double MIN_REGISTRATION_FITNESS = 0.5;  // matched share of the scan to trust a fit
+  welding_demo::TriangleMesh part_mesh;
+  std::unique_ptr<welding_demo::MeshBvh> part_bvh;
+  std::vector<welding_demo::SeamCurve> part_seams;
+  std::unique_ptr<welding_demo::ScanRegistration> part_registration;
+  if (!startup_config->part_mesh.empty())
+  {
+    const auto scale = static_cast<float>(startup_config->part_mesh_scale);
+    if (!welding_demo::loadMesh(startup_config->part_mesh, part_mesh, scale))
+      RCLCPP_WARN(LOGGER, "Could not load part mesh '%s'", startup_config->part_mesh.c_str());
+    else if (!welding_demo::loadSeamCurves(startup_config->part_seams, part_seams, scale))
+      RCLCPP_WARN(LOGGER, "Could not load seam curves '%s'", startup_config->part_seams.c_str());
+    else
+    {
+      part_bvh = std::make_unique<welding_demo::MeshBvh>(part_mesh);
+      part_registration = std::make_unique<welding_demo::ScanRegistration>(
+          welding_demo::sampleSurface(part_mesh, PART_MODEL_POINTS));
+      RCLCPP_INFO(LOGGER, "Loaded part mesh with %zu triangles and %zu seam curves",
+                  part_mesh.triangles.size(), part_seams.size());
+    }
+  }
+
+  // Scan input
+  // ^^^^^^^^^^
+  // Scans arrive on the "points" topic or, from a sensor driver on the same machine, through a
+  // shared memory buffer (``cloud_buffer``, see cloud_replay). Clouds in the buffer are read in
+  // place, without serialization or copies. Every scan is cropped to the fixture region and
+  // voxel-downsampled (``roi_min``, ``roi_max``, ``voxel_size``) before anything else looks at it.
+  std::unique_ptr<welding_demo::CloudRingBuffer> cloud_buffer;
+  uint64_t last_scan = 0;
+  bool cloud_buffer_missing = false;
+  std::shared_ptr<const sensor_msgs::msg::PointCloud2> last_cloud;
+  Eigen::Matrix3Xf cloud_points;
+  Eigen::Matrix3Xf scan_points;
+  // Pose batches of the circle seam, reused across cycles
+  welding_demo::PoseBatch circle_poses;
+  welding_demo::Vector3Batch circle_normals;
+  // The seams of a cycle, filled by the seam sources directly (``resampled_seams`` takes them
+  // through the spline), and the waypoints of the seam being planned. All keep their storage
+  // across cycles, so in steady state handing a seam to the planners does not allocate.
+  welding_demo::SeamBuffer seam_buffer, resampled_seams;
+  std::vector<geometry_msgs::msg::Pose> waypoints;
+  std::vector<Eigen::Isometry3d> seam_transforms;
+  // Messages and the MoveIt interfaces allocate through std::allocator, so the node reuses its
+  // containers across cycles (the seam buffers, waypoints and transforms above) instead. With the
+  // WELDING_DEMO_COUNT_ALLOCATIONS build option the heap allocations of every seam are logged.
+
+  // Cartesian IK at a fixed step leaves small joint oscillations in the plan. They are filtered
+  // out before execution while keeping the tool on the planned path (``smoothing_*`` parameters).
+  // The same scratch state is used for the forward kinematics of weaving and multi-pass planning.
+  moveit::core::RobotState smoothing_state(move_group.getRobotModel());
+  smoothing_state.setToDefaultValues();
+  const moveit::core::LinkModel* tip_link =
+      move_group.getRobotModel()->getLinkModel(move_group.getEndEffectorLink());
+
+  // In-process planning
+  // ^^^^^^^^^^^^^^^^^^^
+  // With ``planning_mode`` "local" Cartesian paths are planned in this process against a local
+  // copy of move_group's planning scene, instead of a computeCartesianPath() service call that
+  // serializes the waypoints and the resulting trajectory. move_group is still used for transits
+  // and execution.
+  std::unique_ptr<welding_demo::LocalCartesianPlanner> local_planner;
+  if (startup_config->planning_mode == "local")
+  {
+    startup.phase("local planning scene");
+    local_planner = std::make_unique<welding_demo::LocalCartesianPlanner>(
+        welding_demo_node, robot_model_loader, planning_group, move_group.getEndEffectorLink());
+    if (!local_planner->ready())
+      local_planner.reset();
+  }
+  // Plan a Cartesian path from ``start`` (group positions). The move_group service plans from the
+  // start state set on ``move_group``.
+  auto planCartesian = [&](const std::vector<double>& start,
+                           const std::vector<geometry_msgs::msg::Pose>& waypoints, double eef_step,
+                           double jump_threshold, moveit_msgs::msg::RobotTrajectory& trajectory) {
+    if (local_planner)
+      return local_planner->plan(start, waypoints, eef_step, jump_threshold, trajectory);
+    return move_group.computeCartesianPath(waypoints, eef_step, jump_threshold, trajectory);
+  };
+
+  // The first IK query pays for the solver's lazy initialization. Solve one at startup so the
+  // first seam is planned as fast as the following ones.
+  startup.phase("kinematics warm-up");
+  if (tip_link)
+  {
+    moveit::core::RobotState warm_up(smoothing_state);
+    warm_up.setFromIK(joint_model_group, smoothing_state.getGlobalLinkTransform(tip_link), 0.05);
+  }
+  startup.finish();
+  startup.report(LOGGER, startup_config->profile_startup);
+
+  // Weaving
+  // ^^^^^^^
+  // The weave is either part of the planned path (``weave_layer`` "plan"), which densifies the
+  // waypoints, or overlaid on the plain seam plan right before execution ("execute"), which keeps
+  // planning and stored plans as cheap as without weaving.
+  //
+  // Multi-pass welds
+  // ^^^^^^^^^^^^^^^^
+  // Passes after the root pass are given as lateral offsets and lifts from the root seam (one
+  // entry per pass in ``pass_lateral_offsets`` and ``pass_lifts``). They are derived from the root
+  // pass joint solution instead of being planned from scratch.
+
+  // Positions of the planning group at a trajectory point, in the order the transit planner uses
+  auto groupPositions = [&](const moveit_msgs::msg::RobotTrajectory& trajectory, bool last) {
+    const auto& jt = trajectory.joint_trajectory;
+    std::vector<double> positions;
+    smoothing_state.setVariablePositions(
+        jt.joint_names, last ? jt.points.back().positions : jt.points.front().positions);
+    smoothing_state.copyJointGroupPositions(joint_model_group, positions);
+    return positions;
+  };
+
+  // Execution
+  // ^^^^^^^^^
+  // With ``execution_action`` set, trajectories are sent to the controller without waiting for
+  // the motion. The last motion of a seam runs while the next seam is planned and the next scan
+  // is processed; the arm's motions still follow one another, each waits for the one before and
+  // logs its progress along the seam meanwhile.
+  constexpr double START_TOLERANCE = 0.01;  // rad, MoveIt's default allowed_start_tolerance
+  std::unique_ptr<welding_demo::AsyncExecutor> async_executor;
+  if (!startup_config->execution_action.empty())
+    async_executor = std::make_unique<welding_demo::AsyncExecutor>(
+        welding_demo_node, startup_config->execution_action);
+  welding_demo::ExecutionPtr in_flight;
+  // The motion in flight is shared with stop(), which cancels it from the stopping thread
+  auto setInFlight = [&](welding_demo::ExecutionPtr execution) {
+    std::lock_guard<std::mutex> lock(stop_mutex_);
+    in_flight = std::move(execution);
+    in_flight_ = in_flight;
+    if (stop_ && in_flight_)
+      in_flight_->cancel();
+  };
+  // Waits for the motion in flight, returns whether it (or nothing) was completed
+  auto finishExecution = [&]() {
+    if (!in_flight)
+      return true;
+    while (!in_flight->wait(std::chrono::seconds(1)))
+    {
+      // Stopping does not wait for the motion, the executor may not deliver its result any more
+      if (stop_)
+        break;
+      const welding_demo::ExecutionProgress progress = in_flight->progress();
+      RCLCPP_INFO(LOGGER, "Executing: waypoint %zu, %.3f of %.3f m along the tool path",
+                  progress.waypoint, progress.arc_length, progress.total_length);
+    }
+    const bool succeeded = in_flight->state() == welding_demo::Execution::State::SUCCEEDED;
+    if (!succeeded)
+      RCLCPP_WARN(LOGGER, "Execution did not succeed, stopped at waypoint %zu",
+                  in_flight->progress().waypoint);
+    setInFlight(nullptr);
+    return succeeded;
+  };
+  // Whether ``trajectory`` starts where the arm is, within the controller's start tolerance
+  auto startsAtCurrentState = [&](const moveit_msgs::msg::RobotTrajectory& trajectory) {
+    const auto& jt = trajectory.joint_trajectory;
+    const moveit::core::RobotStatePtr current = move_group.getCurrentState(1.0);
+    if (!current || jt.points.empty())
+      return false;
+    for (std::size_t j = 0; j < jt.joint_names.size(); ++j)
+      if (std::abs(current->getVariablePosition(jt.joint_names[j]) -
+                   jt.points.front().positions[j]) > START_TOLERANCE)
+        return false;
+    return true;
+  };
+  // Execute ``trajectory`` after the previous motion. Weld motions report their progress against
+  // the tool path and the seam ``waypoints``. Nothing is sent when the previous motion did not
+  // succeed or the arm is not at the start of ``trajectory``; returns whether it was sent.
+  auto execute = [&](const moveit_msgs::msg::RobotTrajectory& trajectory,
+                     const std::vector<geometry_msgs::msg::Pose>* waypoints = nullptr) {
+    if (!finishExecution() || stop_)
+      return false;
+    if (!startsAtCurrentState(trajectory))
+    {
+      RCLCPP_WARN(LOGGER, "The arm is not at the start of the next motion, it is not executed");
+      return false;
+    }
+    if (!async_executor)
+      return static_cast<bool>(move_group.execute(trajectory));
+    std::vector<double> point_lengths, waypoint_lengths;
+    if (waypoints && tip_link)
+    {
+      point_lengths = welding_demo::toolPathLengths(trajectory, smoothing_state, tip_link);
+      waypoint_lengths = welding_demo::waypointPathLengths(*waypoints);
+    }
+    setInFlight(async_executor->execute(trajectory, std::move(point_lengths),
+                                        std::move(waypoint_lengths)));
+    return true;
+  };
+
   // Start the demo loop
   // ^^^^^^^^^^^^^^^^^^^^^^^^^
-  while (1)
+  while (rclcpp::ok() && !stop_)
   {
     visual_tools.prompt("Press 'next' in the RvizVisualToolsGui window to create a plan for a test "
                         "trajectory");
+    if (stop_)
+      break;
+    // One consistent snapshot of the configuration per cycle
+    const welding_demo::WeldingConfigConstPtr config = config_server.get();
+    const std::string& fixture_id = config->fixture_id;
+    // The Cartesian path is interpolated at a resolution of ``eef_step`` (1 cm by default). The
+    // jump threshold defaults to 0.0, effectively disabling it.
+    // Warning - disabling the jump threshold while operating real hardware can cause
+    // large unpredictable motions of redundant joints and could be a safety issue
+    const double jump_threshold = config->jump_threshold;
+    const double eef_step = config->eef_step;
+
+    // The producer may start after this node or restart, keep (re)opening its buffer. A restarted
+    // producer numbers its scans from 1 again.
+    if (!startup_config->cloud_buffer.empty() &&
+        !(cloud_buffer && cloud_buffer->isOpen() && !cloud_buffer->replaced()))
+    {
+      const bool was_open = cloud_buffer && cloud_buffer->isOpen();
+      cloud_buffer = std::make_unique<welding_demo::CloudRingBuffer>(startup_config->cloud_buffer);
+      last_scan = 0;
+      if (cloud_buffer->isOpen())
+        RCLCPP_INFO(LOGGER, "%s cloud buffer '%s'", was_open ? "Reopened" : "Opened",
+                    startup_config->cloud_buffer.c_str());
+      else if (was_open || !cloud_buffer_missing)
+        RCLCPP_WARN(LOGGER, "Waiting for a producer of cloud buffer '%s'",
+                    startup_config->cloud_buffer.c_str());
+      cloud_buffer_missing = !cloud_buffer->isOpen();
+    }
+    welding_demo::CloudView scan;
+    bool buffer_scan =
+        cloud_buffer && cloud_buffer->isOpen() && cloud_buffer->latest(scan, last_scan);
+    if (buffer_scan)
+    {
+      last_scan = scan.sequence;
+      const auto preprocessing_start = std::chrono::steady_clock::now();
+      welding_demo::cropAndDownsample(scan.points(), config->preprocessing, scan_points);
+      const double preprocessing_ms = std::chrono::duration<double, std::milli>(
+                                          std::chrono::steady_clock::now() - preprocessing_start)
+                                          .count();
+      // The scan is read in place; if the producer lapped it meanwhile, the points are torn
+      buffer_scan = cloud_buffer->stillValid(scan);
+      if (buffer_scan)
+        RCLCPP_INFO(LOGGER, "Scan %" PRIu64 " reduced from %u to %ld points in %.2f ms",
+                    scan.sequence, scan.point_count, static_cast<long>(scan_points.cols()),
+                    preprocessing_ms);
+      else
+        RCLCPP_WARN(LOGGER, "Scan %" PRIu64 " was overwritten while it was read, dropping it",
+                    scan.sequence);
+    }
+    bool have_scan = buffer_scan;
+    // Without a new scan in the shared memory buffer, the latest cloud from the topic is used
+    const auto cloud = latestCloud();
+    if (!have_scan && cloud && cloud != last_cloud)
+    {
+      last_cloud = cloud;
+      const auto preprocessing_start = std::chrono::steady_clock::now();
+      welding_demo::cloudPoints(*cloud, cloud_points);
+      welding_demo::cropAndDownsample(cloud_points, config->preprocessing, scan_points);
+      const double preprocessing_ms = std::chrono::duration<double, std::milli>(
+                                          std::chrono::steady_clock::now() - preprocessing_start)
+                                          .count();
+      RCLCPP_INFO(LOGGER, "Cloud reduced from %ld to %ld points in %.2f ms",
+                  static_cast<long>(cloud_points.cols()), static_cast<long>(scan_points.cols()),
+                  preprocessing_ms);
+      have_scan = true;
+    }
 
     // Cartesian Paths
     // ^^^^^^^^^^^^^^^
@@ -102,67 +554,438 @@ int main(int argc, char** argv)
     // from the new start state above.  The initial pose (start state) does not
     // need to be added to the waypoint list but adding it can help with visualizations
 
-    std::vector<geometry_msgs::msg::Pose> waypoints;
-    geometry_msgs::msg::Pose robot_pose;
-    tf2::Vector3 center_pos = tf2::Vector3(0.2, 0, 0.8);
-    tf2::Vector3 goal_pos;
-    tf2::Vector3 goal_dir = tf2::Vector3(1, 0, 0);  // forward pointing unit vec
-    tf2::Vector3 norm_vec;
-    goal_dir *= 0.2;        // circle radius
-    tf2::Quaternion q_rot;  // rotation for the unit vec (needed for the circle generation)
-    for (float angle = 0; angle < 2 * M_PI; angle += 0.5)
+    seam_buffer.clear();
+
+    // Seam extraction
+    // ^^^^^^^^^^^^^^^
+    // With ``seam_source`` "scan" the seams are taken from the latest scan instead: planes are
+    // segmented out of the reduced cloud, their intersections become fillet seams and the gaps
+    // between coplanar plates (``max_butt_gap``) butt seams. The scan is expected in the planning
+    // frame. With ``seam_source`` "cad" they are sampled from the part mesh. Without seams from
+    // either, the circle below is welded.
+    if (have_scan && config->seam_source == "scan")
     {
-      q_rot.setRPY(0, 0, angle);                                 // define rotation
-      goal_pos = center_pos + tf2::quatRotate(q_rot, goal_dir);  // apply the center offset for the
-                                                                 // rotated unit vec
-
-      q_rot.setRPY(0, 0, M_PI - angle);  // align goal orientation towards the center of the circle
-      norm_vec = tf2::quatRotate(q_rot, goal_dir);  // to be substituted with the normal data from PCL. 
-      // convert to Eigen for a moment, and build quaternion from 2 vectors
-      Eigen::Vector3d vec1(norm_vec); // normal
-      Eigen::Vector3d vec2(1, 0, 0);  // fwd direction
-      Eigen::Quaterniond quat = Eigen::Quaterniond::FromTwoVectors(vec1, vec2);
-
-      // convert from vector3 to pose message 
-      robot_pose.position = tf2::toMsg(goal_pos, robot_pose.position);  
-      // convert form quaternion to orientation message
-      geometry_msgs::msg::Quaternion qmsg;
-      qmsg = Eigen::toMsg(quat);
-      robot_pose.orientation = qmsg;  
-      waypoints.push_back(robot_pose);
-      RCLCPP_INFO(LOGGER, "q_rot: %f %f %f %f", q_rot.x(), q_rot.y(), q_rot.z(), q_rot.w());
+      const auto extraction_start = std::chrono::steady_clock::now();
+      const std::vector<welding_demo::ScanPlane> planes =
+          welding_demo::segmentPlanes(scan_points, config->seam_extraction);
+      welding_demo::extractSeams(scan_points, planes, config->seam_extraction, seam_buffer);
+      const double extraction_ms = std::chrono::duration<double, std::milli>(
+                                       std::chrono::steady_clock::now() - extraction_start)
+                                       .count();
+      RCLCPP_INFO(LOGGER, "Extracted %zu seams from %zu planes in %.2f ms", seam_buffer.size(),
+                  planes.size(), extraction_ms);
     }
 
-    // We want the Cartesian path to be interpolated at a resolution of 1 cm
-    // which is why we will specify 0.01 as the max step in Cartesian
-    // translation.  We will specify the jump threshold as 0.0, effectively disabling it.
-    // Warning - disabling the jump threshold while operating real hardware can cause
-    // large unpredictable motions of redundant joints and could be a safety issue
-    moveit_msgs::msg::RobotTrajectory trajectory;
-    const double jump_threshold = 0.0;
-    const double eef_step = 0.01;
-    double fraction =
-        move_group.computeCartesianPath(waypoints, eef_step, jump_threshold, trajectory);
-    RCLCPP_INFO(LOGGER, "Visualizing plan for a Cartesian path (%.2f%% achieved)",
-                fraction * 100.0);
-
-    // Visualize the plan in RViz
-    visual_tools.deleteAllMarkers();
-    visual_tools.publishText(text_pose, "Cartesian_Path", rvt::WHITE, rvt::XLARGE);
-    visual_tools.publishPath(waypoints, rvt::LIME_GREEN, rvt::SMALL);
-    for (std::size_t i = 0; i < waypoints.size(); ++i)
-      visual_tools.publishAxisLabeled(waypoints[i], "pt" + std::to_string(i), rvt::SMALL);
-    visual_tools.trigger();
-    visual_tools.prompt("Press 'next' in the RvizVisualToolsGui window to execute the trajectory");
-    move_group.execute(trajectory);
+    if (part_bvh && config->seam_source == "cad")
+    {
+      const auto import_start = std::chrono::steady_clock::now();
+      welding_demo::sampleCadSeams(*part_bvh, part_seams, config->part_transform,
+                                   config->cad_seams, seam_buffer);
+      const double import_ms = std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - import_start)
+                                   .count();
+      RCLCPP_INFO(LOGGER, "Sampled %zu seams from the part mesh in %.2f ms", seam_buffer.size(),
+                  import_ms);
+      if (have_scan && config->register_part)
+      {
+        const welding_demo::RegistrationResult registration =
+            part_registration->align(scan_points, config->part_transform, config->registration);
+        RCLCPP_INFO(LOGGER,
+                    "Registration %s after %zu iterations in %.2f ms: rmse %.2f mm, %.0f%% of "
+                    "the scan matched",
+                    registration.converged ? "converged" : "stopped", registration.iterations,
+                    registration.elapsed_ms, registration.rmse * 1e3, registration.fitness * 100);
+        if (registration.fitness >= MIN_REGISTRATION_FITNESS)
+          seam_buffer.transform(registration.part_pose * config->part_transform.inverse());
+        else
+          RCLCPP_WARN(LOGGER, "Registration rejected, welding at the nominal part pose");
+      }
+    }
+
+    // The circle is sampled evenly and closed exactly (``circle_points`` or ``circle_angle_step``,
+    // and ``circle_overlap``), every angle is computed from its arc length position in double
+    // precision instead of being accumulated
+    const double perimeter = 2 * M_PI * config->circle_radius;
+    const std::vector<double> circle_positions =
+        welding_demo::closedSeamPositions(perimeter, config->circle_sampling);
+    const auto circle_count = static_cast<Eigen::Index>(circle_positions.size());
+    const Eigen::Array<double, 1, Eigen::Dynamic> angles =
+        Eigen::Map<const Eigen::Array<double, 1, Eigen::Dynamic>>(circle_positions.data(),
+                                                                  circle_count) *
+        (2 * M_PI / perimeter);
+    // All poses are built at once: the points on the circle around ``center``, the normals (to be
+    // substituted with the normal data from PCL) and the orientations turning the normals onto the
+    // forward direction. They go into the seam buffer as they are.
+    const double radius = config->circle_radius;
+    circle_poses.resize(circle_count);
+    circle_poses.positions.row(0).array() = config->center.x() + radius * angles.cos();
+    circle_poses.positions.row(1).array() = config->center.y() + radius * angles.sin();
+    circle_poses.positions.row(2).setConstant(config->center.z());
+    circle_normals.resize(3, circle_count);
+    circle_normals.row(0).array() = -radius * angles.cos();
+    circle_normals.row(1).array() = radius * angles.sin();
+    circle_normals.row(2).setZero();
+    welding_demo::seamOrientations(circle_normals, circle_poses.orientations);
+    // Sparse waypoints are joined by straight lines in the Cartesian planner. Resampling them
+    // along a spline through the waypoints (``seam_spline_step``) keeps the path on the curve.
+    if (config->seam_spline_step > 0.0 && !seam_buffer.empty())
+    {
+      resampled_seams.clear();
+      for (std::size_t i = 0; i < seam_buffer.size(); ++i)
+      {
+        seam_buffer.waypoints(i, false, waypoints);
+        resampled_seams.add(seam_buffer.name(i), welding_demo::SeamSpline(waypoints).sample(
+                                                     config->seam_spline_step));
+      }
+      std::swap(seam_buffer, resampled_seams);
+    }
+    if (seam_buffer.empty() && config->seam_spline_step > 0.0)
+    {
+      // The circle is a closed spline through its first lap, so that the resampled seam closes
+      // smoothly and welds the same overlap past its start
+      const auto lap = std::lower_bound(circle_positions.begin(), circle_positions.end(),
+                                        perimeter - 1e-9) -
+                       circle_positions.begin();
+      circle_poses.toMsgs(waypoints);
+      waypoints.resize(static_cast<std::size_t>(lap));
+      welding_demo::ClosedSeamSampling sampling;
+      sampling.max_spacing = config->seam_spline_step;
+      sampling.overlap = config->circle_sampling.overlap;
+      seam_buffer.add("circle", welding_demo::SeamSpline(waypoints, true).sample(sampling));
+    }
+    else if (seam_buffer.empty())
+      seam_buffer.add("circle", circle_poses);
+    if (buffer_scan)
+      RCLCPP_INFO(LOGGER, "Scan %" PRIu64 " (%u points): %.2f ms from scan to seam poses",
+                  scan.sequence, scan.point_count,
+                  (welding_demo::CloudRingBuffer::nowNs() - scan.stamp_ns) * 1e-6);
+
+    // Seam sequencing
+    // ^^^^^^^^^^^^^^^
+    // Order the seams and pick their direction so that the air moves between them are as short
+    // as possible. The costs are estimated from IK solutions of the seam endpoints.
+    moveit::core::RobotStatePtr current_state = move_group.getCurrentState(10.0);
+    std::vector<welding_demo::SequencedSeam> sequence;
+    std::vector<Eigen::VectorXd> endpoints;
+    if (current_state)
+    {
+      const std::size_t ik_failures =
+          welding_demo::solveSeamEndpoints(seam_buffer, *current_state, joint_model_group,
+                                           endpoints);
+      if (ik_failures > 0)
+        RCLCPP_WARN(LOGGER, "No IK solution for %zu seam endpoints", ik_failures);
+      welding_demo::SeamSequencer sequencer(
+          welding_demo::transitCostMatrix(endpoints, max_joint_velocities));
+      double air_time = 0.0;
+      sequence = sequencer.solve(welding_demo::SeamSequencer::Options(), &air_time);
+      RCLCPP_INFO(LOGGER, "Sequenced %zu seams, estimated air-move time %.2f s", sequence.size(),
+                  air_time);
+    }
+    else
+    {
+      RCLCPP_WARN(LOGGER, "No current robot state, welding seams in their given order");
+      for (std::size_t i = 0; i < seam_buffer.size(); ++i)
+        sequence.push_back({ i, false });
+    }
+
+    for (std::size_t next = 0; next < sequence.size();)
+    {
+      const welding_demo::SequencedSeam& step = sequence[next++];
+      const uint64_t allocations_start = welding_demo::heapAllocations();
+      seam_buffer.waypoints(step.seam, step.reversed, waypoints);
+      RCLCPP_INFO(LOGGER, "Planning seam '%s'%s", seam_buffer.name(step.seam).c_str(),
+                  step.reversed ? " (reversed)" : "");
+
+      // Check the seam against the reachability map. The seam is defined in the planning frame, so
+      // the workpiece placement is the identity here.
+      if (!reachability_map.empty())
+      {
+        seam_buffer.transforms(step.seam, step.reversed, seam_transforms);
+        std::size_t failed_index = 0;
+        const auto start = std::chrono::steady_clock::now();
+        const bool reachable =
+            reachability_map.canWeld(seam_transforms, Eigen::Isometry3d::Identity(),
+                                     config->min_manipulability, &failed_index);
+        const double elapsed_us = std::chrono::duration<double, std::micro>(
+                                      std::chrono::steady_clock::now() - start)
+                                      .count();
+        if (!reachable)
+        {
+          RCLCPP_WARN(LOGGER, "Seam is not reachable at waypoint %zu (checked in %.1f us)",
+                      failed_index, elapsed_us);
+          continue;
+        }
+        RCLCPP_INFO(LOGGER, "Seam is reachable (checked in %.1f us)", elapsed_us);
+      }
+
+      if (!config->weave_at_execution)
+        welding_demo::applyWeave(waypoints, config->weave);
+      welding_demo::addApproachAndRetract(waypoints, config->approach_distance,
+                                          config->retract_distance);
+      const uint64_t seam_key = welding_demo::PlanKey()
+                                    .add(fixture_id)
+                                    .add(waypoints)
+                                    .add(eef_step, 1e-6)
+                                    .add(jump_threshold, 1e-6)
+                                    .value();
+
+      // Plan the transit from the current state to the approach pose. The IK for the approach pose
+      // is seeded with the seam entry configuration, which keeps it on the same branch every cycle
+      // so the roadmap lookups hit.
+      // A stored IK seed takes precedence, it keeps the solution stable across restarts.
+      const auto cycle_start = std::chrono::steady_clock::now();
+      moveit_msgs::msg::RobotTrajectory transit;
+      bool have_transit = false;
+      std::vector<double> cartesian_start_positions;
+      moveit::core::RobotStatePtr start_state = move_group.getCurrentState(10.0);
+      // While the previous seam is still being welded, planning starts where it ends
+      if (start_state && in_flight && !in_flight->done())
+      {
+        start_state->setVariablePositions(in_flight->jointNames(), in_flight->finalPositions());
+        move_group.setStartState(*start_state);
+      }
+      if (start_state)
+      {
+        start_state->copyJointGroupPositions(joint_model_group, cartesian_start_positions);
+        moveit::core::RobotState approach_state(*start_state);
+        std::vector<double> seed;
+        const bool stored_seed = plan_store && plan_store->loadSeed(seam_key, seed);
+        const std::size_t entry = 2 * step.seam + (step.reversed ? 1 : 0);
+        if (stored_seed)
+          approach_state.setJointGroupPositions(joint_model_group, seed);
+        else if (entry < endpoints.size())
+          approach_state.setJointGroupPositions(joint_model_group, endpoints[entry]);
+        if (approach_state.setFromIK(joint_model_group, waypoints.front(), 0.05))
+        {
+          std::vector<double> start_positions = cartesian_start_positions;
+          std::vector<double> approach_positions;
+          approach_state.copyJointGroupPositions(joint_model_group, approach_positions);
+          if (plan_store && !stored_seed)
+            plan_store->storeSeed(seam_key, approach_positions);
+          bool cache_hit = false;
+          const auto transit_start = std::chrono::steady_clock::now();
+          have_transit =
+              transit_planner.plan(start_positions, approach_positions, transit, &cache_hit);
+          const double transit_ms = std::chrono::duration<double, std::milli>(
+                                        std::chrono::steady_clock::now() - transit_start)
+                                        .count();
+          RCLCPP_INFO(LOGGER, "Transit %s in %.2f ms (%s)", have_transit ? "planned" : "failed",
+                      transit_ms, cache_hit ? "roadmap" : "move_group");
+          if (have_transit)
+          {
+            move_group.setStartState(approach_state);
+            cartesian_start_positions = approach_positions;
+          }
+          if (have_transit && !cache_hit && !transit_roadmap_file.empty())
+            transit_planner.roadmap().save(transit_roadmap_file);
+          if (have_transit && !cache_hit && plan_store)
+          {
+            const uint64_t transit_key = welding_demo::PlanKey()
+                                             .add(start_positions, 1e-3)
+                                             .add(approach_positions, 1e-3)
+                                             .value();
+            plan_store->storeTrajectory("transit", transit_key, transit);
+          }
+        }
+        else
+        {
+          RCLCPP_WARN(LOGGER, "No IK solution for the approach pose of seam '%s'",
+                      seam_buffer.name(step.seam).c_str());
+        }
+      }
+
+      // Plan the seam itself, unless the same seam was already planned from the same start state.
+      // Only complete plans are stored. The trajectory is owned by a handle that is passed on to
+      // validation, visualization and pass derivation without copying its points. The plan store
+      // and the controller goal take it by value; these copies are counted with the handle's
+      // copy-on-write copies in the log after execution.
+      welding_demo::TrajectoryHandle trajectory;
+      const std::size_t copied_points_start = welding_demo::TrajectoryHandle::copiedPoints();
+      const uint64_t plan_key =
+          welding_demo::PlanKey(seam_key).add(cartesian_start_positions, 1e-3).value();
+      double fraction = 0.0;
+      const bool warm_start =
+          plan_store && plan_store->loadTrajectory("seam", plan_key, trajectory.edit());
+      if (warm_start)
+      {
+        fraction = 1.0;
+      }
+      else
+      {
+        fraction = planCartesian(cartesian_start_positions, waypoints, eef_step, jump_threshold,
+                                 trajectory.edit());
+        if (config->smoothing.half_window > 0 && tip_link)
+        {
+          const welding_demo::SmoothingResult smoothing = welding_demo::smoothTrajectory(
+              trajectory.edit(), smoothing_state, tip_link, config->smoothing);
+          RCLCPP_INFO(LOGGER,
+                      "Smoothed trajectory, max TCP deviation %.3f mm and %.3f deg "
+                      "(%zu points limited)",
+                      smoothing.max_tcp_deviation * 1000.0,
+                      smoothing.max_orientation_deviation * 180.0 / M_PI,
+                      smoothing.limited_points);
+        }
+        if (plan_store && fraction >= 1.0)
+        {
+          plan_store->storeTrajectory("seam", plan_key, *trajectory);
+          welding_demo::TrajectoryHandle::countCopy(*trajectory);
+        }
+      }
+
+      // Derive the fill and cap passes from the root pass. A pass that cannot be derived (IK
+      // branch flip) is planned as a Cartesian path from the IK solution of its first pose.
+      std::vector<moveit_msgs::msg::RobotTrajectory> passes;
+      for (std::size_t i = 0; i < config->pass_offsets.size() && fraction >= 1.0 && tip_link; ++i)
+      {
+        const auto& offset = config->pass_offsets[i];
+        const auto pass_start = std::chrono::steady_clock::now();
+        const uint64_t pass_key = welding_demo::PlanKey(plan_key)
+                                      .add(offset.lateral, 1e-6)
+                                      .add(offset.lift, 1e-6)
+                                      .value();
+        moveit_msgs::msg::RobotTrajectory pass;
+        const char* source = "stored";
+        const bool stored_pass = plan_store && plan_store->loadTrajectory("pass", pass_key, pass);
+        bool have_pass = stored_pass;
+        if (!have_pass)
+        {
+          source = "derived";
+          have_pass = welding_demo::derivePass(*trajectory, smoothing_state, joint_model_group,
+                                               tip_link, offset, pass);
+        }
+        if (!have_pass)
+        {
+          source = "planned";
+          const auto pass_waypoints = welding_demo::offsetWaypoints(waypoints, offset);
+          moveit::core::RobotState pass_start_state(move_group.getRobotModel());
+          pass_start_state.setToDefaultValues();
+          pass_start_state.setJointGroupPositions(joint_model_group,
+                                                  groupPositions(*trajectory, false));
+          if (pass_start_state.setFromIK(joint_model_group, pass_waypoints.front(), 0.05))
+          {
+            std::vector<double> pass_start_positions;
+            pass_start_state.copyJointGroupPositions(joint_model_group, pass_start_positions);
+            move_group.setStartState(pass_start_state);
+            have_pass = planCartesian(pass_start_positions, pass_waypoints, eef_step,
+                                      jump_threshold, pass) >= 1.0;
+          }
+        }
+        const double pass_ms = std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - pass_start)
+                                   .count();
+        if (!have_pass)
+        {
+          RCLCPP_WARN(LOGGER, "Pass %zu could not be planned, skipping the remaining passes",
+                      i + 2);
+          break;
+        }
+        RCLCPP_INFO(LOGGER, "Pass %zu %s in %.2f ms", i + 2, source, pass_ms);
+        if (plan_store && !stored_pass)
+          plan_store->storeTrajectory("pass", pass_key, pass);
+        passes.push_back(std::move(pass));
+      }
+      move_group.setStartStateToCurrentState();
+      const double planning_ms = std::chrono::duration<double, std::milli>(
+                                     std::chrono::steady_clock::now() - cycle_start)
+                                     .count();
+      RCLCPP_INFO(LOGGER, "Seam planned in %.2f ms (%s start)", planning_ms,
+                  warm_start ? "warm" : "cold");
+      RCLCPP_INFO(LOGGER, "Visualizing plan for a Cartesian path (%.2f%% achieved)",
+                  fraction * 100.0);
+
+      // Visualize the plan in RViz
+      visual_tools.deleteAllMarkers();
+      visual_tools.publishText(text_pose, "Cartesian_Path", rvt::WHITE, rvt::XLARGE);
+      visual_tools.publishPath(waypoints, rvt::LIME_GREEN, rvt::SMALL);
+      for (std::size_t i = 0; i < waypoints.size(); ++i)
+        visual_tools.publishAxisLabeled(waypoints[i], "pt" + std::to_string(i), rvt::SMALL);
+      {
+        // The visualization only reads the plan, it shares the trajectory until published
+        const auto planned = trajectory.share();
+        visual_tools.publishTrajectoryLine(*planned, joint_model_group, rvt::BLUE);
+      }
+      visual_tools.trigger();
+      visual_tools.prompt(
+          "Press 'next' in the RvizVisualToolsGui window to execute the trajectory");
+      if (stop_)
+        break;
+      if (config->weave_at_execution && tip_link &&
+          !welding_demo::applyWeave(trajectory.edit(), smoothing_state, joint_model_group,
+                                    tip_link, config->weave, config->weave_period))
+        RCLCPP_WARN(LOGGER, "Weave of seam '%s' is infeasible for the arm, welding without it",
+                    seam_buffer.name(step.seam).c_str());
+      // The seam was planned from where the previous motion ends. If that motion did not
+      // succeed, the arm is somewhere else: the seam is planned again from the current state.
+      if (!finishExecution() && !stop_)
+      {
+        RCLCPP_WARN(LOGGER, "Planning seam '%s' again from the current state",
+                    seam_buffer.name(step.seam).c_str());
+        --next;
+        continue;
+      }
+      // A motion that fails stops the seam, its remaining motions are not sent
+      const bool seam_sent =
+          (!have_transit || execute(transit)) && execute(*trajectory, &waypoints);
+      if (seam_sent)
+        welding_demo::TrajectoryHandle::countCopy(*trajectory);  // into the goal
+      bool executing = seam_sent;
+      const moveit_msgs::msg::RobotTrajectory* previous = &*trajectory;
+      std::size_t executed_passes = 0;
+      for (auto& pass : passes)
+      {
+        if (!executing)
+          break;
+        moveit_msgs::msg::RobotTrajectory pass_transit;
+        if (!transit_planner.plan(groupPositions(*previous, true), groupPositions(pass, false),
+                                  pass_transit))
+        {
+          RCLCPP_WARN(LOGGER, "No transit to the next pass, skipping the remaining passes");
+          break;
+        }
+        if (config->weave_at_execution && tip_link &&
+            !welding_demo::applyWeave(pass, smoothing_state, joint_model_group, tip_link,
+                                      config->weave, config->weave_period))
+          RCLCPP_WARN(LOGGER, "Weave of a pass is infeasible for the arm, welding it without");
+        executing = execute(pass_transit) &&
+                    execute(pass, &waypoints);  // the pass follows the root seam waypoints
+        executed_passes += executing;
+        previous = &pass;
+      }
+      if (!executing)
+        RCLCPP_WARN(LOGGER, "Execution of seam '%s' stopped, its remaining motions are skipped",
+                    seam_buffer.name(step.seam).c_str());
+
+      // Hand the executed trajectories on (logging, process monitoring). They are not used here
+      // any more, so they are moved into the messages.
+      if (seam_sent)
+      {
+        const std::size_t executed_points = trajectory->joint_trajectory.points.size();
+        trajectory_publisher_->publish(
+            std::make_unique<trajectory_msgs::msg::JointTrajectory>(
+                std::move(trajectory.release().joint_trajectory)));
+        for (std::size_t i = 0; i < executed_passes; ++i)
+          trajectory_publisher_->publish(
+              std::make_unique<trajectory_msgs::msg::JointTrajectory>(
+                  std::move(passes[i].joint_trajectory)));
+        RCLCPP_INFO(LOGGER, "Seam trajectory of %zu points sent to execution, %zu points copied",
+                    executed_points,
+                    welding_demo::TrajectoryHandle::copiedPoints() - copied_points_start);
+      }
+      if (welding_demo::countingHeapAllocations())
+        RCLCPP_INFO(LOGGER, "Seam '%s' made %" PRIu64 " heap allocations",
+                    seam_buffer.name(step.seam).c_str(),
+                    welding_demo::heapAllocations() - allocations_start);
+    }
 
     visual_tools.deleteAllMarkers();
     visual_tools.trigger();
   }
-
-  rclcpp::shutdown();
-  return 0;
+  // A motion still running when the loop ends was canceled by stop()
+  setInFlight(nullptr);
 }
+}  // namespace welding_demo
+
+RCLCPP_COMPONENTS_REGISTER_NODE(welding_demo::WeldingDemo)
 
 // Some snippets from other demos...
 
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <welding_demo/trajectory_compression.hpp>
+#include <welding_demo/trajectory_time.hpp>
+
+#include <cstdint>
+
+namespace
+{
+// A single joint moving by one radian at constant speed over ``duration``
+trajectory_msgs::msg::JointTrajectory makeTrajectory(double duration)
+{
+  trajectory_msgs::msg::JointTrajectory trajectory;
+  trajectory.joint_names = { "joint_1" };
+  trajectory.points.resize(2);
+  trajectory.points[0].positions = { 0.0 };
+  trajectory.points[0].velocities = { 1.0 / duration };
+  trajectory.points[1].positions = { 1.0 };
+  trajectory.points[1].velocities = { 1.0 / duration };
+  trajectory.points[1].time_from_start = welding_demo::fromSec(duration);
+  return trajectory;
+}
+
+int64_t nanoseconds(const builtin_interfaces::msg::Duration& d)
+{
+  return int64_t{ d.sec } * 1000000000 + d.nanosec;
+}
+}  // namespace
+
+// Durations just above a multiple of the period must not produce a repeated or nanosecond-short
+// last interval
+TEST(DecompressTrajectory, TimesStrictlyIncrease)
+{
+  for (const double period : { 0.01, 0.004 })
+    for (int ms = 1; ms < 5000; ++ms)
+    {
+      const double duration = 1e-3 * ms;
+      const trajectory_msgs::msg::JointTrajectory in = makeTrajectory(duration);
+      trajectory_msgs::msg::JointTrajectory out;
+      welding_demo::decompressTrajectory(in, out, period);
+
+      ASSERT_GE(out.points.size(), 2u);
+      EXPECT_EQ(nanoseconds(out.points.front().time_from_start), 0);
+      EXPECT_EQ(nanoseconds(out.points.back().time_from_start),
+                nanoseconds(in.points.back().time_from_start));
+      for (std::size_t i = 1; i < out.points.size(); ++i)
+        ASSERT_GT(nanoseconds(out.points[i].time_from_start),
+                  nanoseconds(out.points[i - 1].time_from_start) + 1000)
+            << "duration " << duration << " s, period " << period << " s, point " << i;
+    }
+}
+
+// A regular sample a few nanoseconds before the end is left out, its interval would blow up the
+// velocities estimated from the resampled trajectory
+TEST(DecompressTrajectory, NoNanosecondLastInterval)
+{
+  for (const double duration : { 1.0 + 3e-9, 2.5 + 1e-6 })
+  {
+    trajectory_msgs::msg::JointTrajectory out;
+    welding_demo::decompressTrajectory(makeTrajectory(duration), out, 0.01);
+
+    ASSERT_GE(out.points.size(), 2u);
+    const int64_t last = nanoseconds(out.points.back().time_from_start) -
+                         nanoseconds(out.points[out.points.size() - 2].time_from_start);
+    EXPECT_GT(last, 9000000) << "duration " << duration << " s";
+  }
+}
+
+TEST(DecompressTrajectory, SinglePoint)
+{
+  trajectory_msgs::msg::JointTrajectory in = makeTrajectory(1.0);
+  in.points.resize(1);
+  trajectory_msgs::msg::JointTrajectory out;
+  welding_demo::decompressTrajectory(in, out, 0.01);
+
+  ASSERT_EQ(out.points.size(), 1u);
+  EXPECT_DOUBLE_EQ(out.points[0].positions[0], 0.0);
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <welding_demo/trajectory_handle.hpp>
+
+#include <utility>
+
+namespace
+{
+constexpr std::size_t POINT_COUNT = 100000;
+
+// A seam trajectory of a 6 axis arm, large enough that a stray copy would be noticed
+moveit_msgs::msg::RobotTrajectory makeTrajectory()
+{
+  moveit_msgs::msg::RobotTrajectory trajectory;
+  auto& jt = trajectory.joint_trajectory;
+  jt.joint_names = { "joint_1", "joint_2", "joint_3", "joint_4", "joint_5", "joint_6" };
+  jt.points.resize(POINT_COUNT);
+  for (std::size_t i = 0; i < POINT_COUNT; ++i)
+  {
+    jt.points[i].positions.assign(6, 1e-3 * static_cast<double>(i));
+    jt.points[i].time_from_start.nanosec = static_cast<uint32_t>(i);
+  }
+  return trajectory;
+}
+
+const void* pointData(const moveit_msgs::msg::RobotTrajectory& trajectory)
+{
+  return trajectory.joint_trajectory.points.data();
+}
+}  // namespace
+
+TEST(TrajectoryHandle, MovingDoesNotCopy)
+{
+  const std::size_t copied = welding_demo::TrajectoryHandle::copiedPoints();
+  welding_demo::TrajectoryHandle planned(makeTrajectory());
+  const void* data = pointData(*planned);
+
+  welding_demo::TrajectoryHandle validated(std::move(planned));
+  welding_demo::TrajectoryHandle executed;
+  executed = std::move(validated);
+  executed.edit().joint_trajectory.points.front().positions[0] = -1.0;
+
+  EXPECT_EQ(pointData(*executed), data);
+  EXPECT_EQ(executed->joint_trajectory.points.size(), POINT_COUNT);
+  EXPECT_EQ(welding_demo::TrajectoryHandle::copiedPoints(), copied);
+}
+
+TEST(TrajectoryHandle, ReleaseMovesThePointsOut)
+{
+  const std::size_t copied = welding_demo::TrajectoryHandle::copiedPoints();
+  welding_demo::TrajectoryHandle handle(makeTrajectory());
+  const void* data = pointData(*handle);
+
+  const moveit_msgs::msg::RobotTrajectory released = handle.release();
+
+  EXPECT_EQ(pointData(released), data);
+  EXPECT_EQ(released.joint_trajectory.points.size(), POINT_COUNT);
+  EXPECT_TRUE(handle->joint_trajectory.points.empty());
+  EXPECT_EQ(welding_demo::TrajectoryHandle::copiedPoints(), copied);
+}
+
+TEST(TrajectoryHandle, EditingASharedTrajectoryCopiesOnce)
+{
+  welding_demo::TrajectoryHandle handle(makeTrajectory());
+  const auto reader = handle.share();
+  const std::size_t copied = welding_demo::TrajectoryHandle::copiedPoints();
+
+  handle.edit().joint_trajectory.points.front().positions[0] = -1.0;
+  handle.edit().joint_trajectory.points.back().positions[0] = -1.0;
+
+  // The reader keeps the trajectory it was given, the writer works on its own copy
+  EXPECT_NE(pointData(*handle), pointData(*reader));
+  EXPECT_DOUBLE_EQ(reader->joint_trajectory.points.front().positions[0], 0.0);
+  EXPECT_DOUBLE_EQ(handle->joint_trajectory.points.front().positions[0], -1.0);
+  EXPECT_EQ(welding_demo::TrajectoryHandle::copiedPoints() - copied, POINT_COUNT);
+}
+
+TEST(TrajectoryHandle, ReleasedReaderIsNotCopied)
+{
+  welding_demo::TrajectoryHandle handle(makeTrajectory());
+  const void* data = pointData(*handle);
+  const std::size_t copied = welding_demo::TrajectoryHandle::copiedPoints();
+  {
+    const auto reader = handle.share();
+    EXPECT_EQ(pointData(*reader), data);
+  }
+  handle.edit().joint_trajectory.points.front().positions[0] = -1.0;
+
+  EXPECT_EQ(pointData(*handle), data);
+  EXPECT_EQ(welding_demo::TrajectoryHandle::copiedPoints(), copied);
+}
+
+TEST(TrajectoryHandle, CountsCopiesMadeOutside)
+{
+  const welding_demo::TrajectoryHandle handle(makeTrajectory());
+  const std::size_t copied = welding_demo::TrajectoryHandle::copiedPoints();
+
+  welding_demo::TrajectoryHandle::countCopy(*handle);
+
+  EXPECT_EQ(welding_demo::TrajectoryHandle::copiedPoints() - copied, POINT_COUNT);
+}
+
+TEST(TrajectoryHandle, MovedFromHandleCanBeReused)
+{
+  welding_demo::TrajectoryHandle handle(makeTrajectory());
+  welding_demo::TrajectoryHandle other(std::move(handle));
+
+  handle.edit().joint_trajectory.points.resize(1);  // NOLINT(bugprone-use-after-move)
+
+  EXPECT_EQ(handle->joint_trajectory.points.size(), 1u);
+  EXPECT_EQ(other->joint_trajectory.points.size(), POINT_COUNT);
+}